@@ -0,0 +1,211 @@
+
+/********************************************************************************************* 
+
+    areaFile.cpp
+
+    Copyright (c) 2016, Jan C. Depner
+
+
+    This file is part of geCache.
+
+    geCache is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    geCache is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with geCache.  If not, see <http://www.gnu.org/licenses/>.
+
+*********************************************************************************************/
+
+
+
+#include "geCacheEngine.hpp"
+
+
+/*!
+  Writes the area file for a saved cache (save_dir_geCache.kml).  This is a KML file containing the rectangle or polygon that the
+  cache was built for so that you can see the area in Google Earth.  Returns false if the file couldn't be created.
+*/
+
+uint8_t 
+writeAreaFile (const QString &save_dir, OPTIONS *options)
+{
+  QString areaName = QFileInfo (save_dir).baseName ();
+  char area_name[256];
+  strcpy (area_name, areaName.toLatin1 ());
+
+  FILE *fp;
+  char fname[1024];
+  strcpy (fname, QString (save_dir + "_geCache.kml").toLatin1 ());
+
+  if ((fp = fopen (fname, "w")) == NULL) return (false);
+
+  fprintf (fp, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  fprintf (fp, "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n");
+  fprintf (fp, "  <Document>\n");
+  fprintf (fp, "    <Style id=\"Transparent\">\n");
+  fprintf (fp, "      <LineStyle>\n");
+  fprintf (fp, "        <width>3</width>\n");
+  fprintf (fp, "      </LineStyle>\n");
+  fprintf (fp, "      <PolyStyle>\n");
+  fprintf (fp, "        <color>00000000</color>\n");
+  fprintf (fp, "        <outline>1</outline>\n");
+  fprintf (fp, "        <fill>0</fill>\n");
+  fprintf (fp, "      </PolyStyle>\n");
+  fprintf (fp, "    </Style>\n");
+
+
+  if (options->shape_tab == POLY_TAB && options->polygon.size ())
+    {
+      fprintf (fp, "    <Placemark>\n");
+      fprintf (fp, "      <name>%s (polygon)</name>\n", area_name);
+      fprintf (fp, "      <styleUrl>#Transparent</styleUrl>\n");
+
+      fprintf (fp, "      <Polygon>\n");
+      fprintf (fp, "        <tessellate>1</tessellate>\n");
+      fprintf (fp, "        <altitudeMode>clampToGround</altitudeMode>\n");
+      fprintf (fp, "        <outerBoundaryIs>\n");
+      fprintf (fp, "          <LinearRing>\n");
+      fprintf (fp, "            <coordinates>\n");
+
+      for (uint32_t i = 0 ; i < options->polygon.size () ; i++)
+        {
+          //  Make sure we haven't created any duplicate points
+
+          if (i && options->polygon[i].x == options->polygon[i - 1].x && options->polygon[i].y == options->polygon[i - 1].y) continue;
+
+          fprintf (fp, "              %.11f,%.11f,10\n", options->polygon[i].x, options->polygon[i].y);
+        }
+
+      fprintf (fp, "              %.11f,%.11f,10\n", options->polygon[0].x, options->polygon[0].y);
+      fprintf (fp, "            </coordinates>\n");
+      fprintf (fp, "          </LinearRing>\n");
+      fprintf (fp, "        </outerBoundaryIs>\n");
+      fprintf (fp, "      </Polygon>\n");
+      fprintf (fp, "    </Placemark>\n");
+    }
+  else
+    {
+      fprintf (fp, "    <Placemark>\n");
+      fprintf (fp, "      <name>%s (rectangle)</name>\n", area_name);
+      fprintf (fp, "      <styleUrl>#Transparent</styleUrl>\n");
+      fprintf (fp, "      <Polygon>\n");
+      fprintf (fp, "        <extrude>1</extrude>\n");
+      fprintf (fp, "        <tessellate>1</tessellate>\n");
+      fprintf (fp, "        <altitudeMode>clampToGround</altitudeMode>\n");
+      fprintf (fp, "        <outerBoundaryIs>\n");
+      fprintf (fp, "          <LinearRing>\n");
+      fprintf (fp, "            <coordinates>\n");
+      fprintf (fp, "              %.11f,%.11f,10\n", options->cache_mbr.min_x, options->cache_mbr.min_y);
+      fprintf (fp, "              %.11f,%.11f,10\n", options->cache_mbr.min_x, options->cache_mbr.max_y);
+      fprintf (fp, "              %.11f,%.11f,10\n", options->cache_mbr.max_x, options->cache_mbr.max_y);
+      fprintf (fp, "              %.11f,%.11f,10\n", options->cache_mbr.max_x, options->cache_mbr.min_y);
+      fprintf (fp, "              %.11f,%.11f,10\n", options->cache_mbr.min_x, options->cache_mbr.min_y);
+      fprintf (fp, "            </coordinates>\n");
+      fprintf (fp, "          </LinearRing>\n");
+      fprintf (fp, "        </outerBoundaryIs>\n");
+      fprintf (fp, "      </Polygon>\n");
+      fprintf (fp, "    </Placemark>\n");
+    }
+
+  fprintf (fp, "  </Document>\n");
+  fprintf (fp, "</kml>\n");
+
+  fclose (fp);
+
+  return (true);
+}
+
+
+
+/*!
+  Reads the rectangle or polygon from an area file (either one that writeAreaFile wrote for a saved cache or any other KML file with
+  a polygon in it).  The first set of coordinates in the file is used.  Since version 1.03 geCache names the placemark "... (rectangle)"
+  or "... (polygon)" and anything else is treated as a polygon.  The coordinates can be one per line (the way we write them) or all on
+  one line (the way most other programs write them).  On success the polygon, the area MBR, and the shape tab are set in options.
+  Returns false if the file can't be read or doesn't have at least three points.
+*/
+
+uint8_t 
+readAreaFile (const QString &area_file, OPTIONS *options)
+{
+  QFile file (area_file);
+
+  if (!file.open (QIODevice::ReadOnly | QIODevice::Text)) return (false);
+
+  QString kml = QString::fromUtf8 (file.readAll ());
+
+  file.close ();
+
+
+  int32_t start = kml.indexOf ("<coordinates>");
+  int32_t end = kml.indexOf ("</coordinates>");
+
+  if (start < 0 || end < start) return (false);
+
+
+  //  Look for the name to see if it is a polygon (default) or a rectangle.
+
+  uint8_t rect_flag = false;
+  int32_t name = kml.indexOf ("<name>");
+
+  if (name >= 0 && name < start && kml.mid (name, kml.indexOf ("</name>", name) - name).contains ("rectangle")) rect_flag = true;
+
+
+  start += (int32_t) strlen ("<coordinates>");
+
+  QStringList points = kml.mid (start, end - start).split (QRegExp ("\\s+"), QString::SkipEmptyParts);
+
+  std::vector<NV_F64_COORD2> polygon;
+
+  for (int32_t i = 0 ; i < points.size () ; i++)
+    {
+      QStringList values = points.at (i).split (",");
+
+      if (values.size () < 2) continue;
+
+      NV_F64_COORD2 pnt = {values.at (0).toDouble (), values.at (1).toDouble ()};
+      polygon.push_back (pnt);
+    }
+
+  if (polygon.size () < 3) return (false);
+
+
+  //  Drop the closing point (we close the polygon ourselves).
+
+  if (polygon.size () > 3 && polygon.front ().x == polygon.back ().x && polygon.front ().y == polygon.back ().y) polygon.pop_back ();
+
+
+  options->cache_mbr.min_y = 99999999999.0;
+  options->cache_mbr.min_x = 99999999999.0;
+  options->cache_mbr.max_y = -99999999999.0;
+  options->cache_mbr.max_x = -99999999999.0;
+
+  for (uint32_t i = 0 ; i < polygon.size () ; i++)
+    {
+      if (polygon[i].y < options->cache_mbr.min_y) options->cache_mbr.min_y = polygon[i].y;
+      if (polygon[i].y > options->cache_mbr.max_y) options->cache_mbr.max_y = polygon[i].y;
+      if (polygon[i].x < options->cache_mbr.min_x) options->cache_mbr.min_x = polygon[i].x;
+      if (polygon[i].x > options->cache_mbr.max_x) options->cache_mbr.max_x = polygon[i].x;
+    }
+
+
+  if (rect_flag)
+    {
+      options->polygon.clear ();
+      options->shape_tab = RECT_TAB;
+    }
+  else
+    {
+      options->polygon = polygon;
+      options->shape_tab = POLY_TAB;
+    }
+
+  return (true);
+}
@@ -0,0 +1,718 @@
+
+/********************************************************************************************* 
+
+    batchBuild.cpp
+
+    Copyright (c) 2016, Jan C. Depner
+
+
+    This file is part of geCache.
+
+    geCache is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    geCache is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with geCache.  If not, see <http://www.gnu.org/licenses/>.
+
+*********************************************************************************************/
+
+
+
+#include "geCacheEngine.hpp"
+
+#include <csignal>
+
+
+/*!
+  Batch (headless) cache builds.  Running
+
+      geCache --build AREA.kml --out SAVE_DIR [--box-size METERS] [--dwell SECONDS] [--ge-name NAME] [--ge-dir DIR]
+
+  builds the cache for the rectangle or polygon in AREA.kml (see readAreaFile) without creating any widgets so that builds can
+  be run from cron or over ssh (Google Earth still needs a display, e.g. Xvfb).  --build-rect SOUTH,WEST,NORTH,EAST can be used
+  instead of --build for a rectangle.  Anything that isn't given on the command line comes from the user's geCache settings, which
+  are not changed.  The build is always a fresh, unattended build.  The cache is saved to SAVE_DIR_seg001, SAVE_DIR_seg002, ...
+  with the segment manifest in SAVE_DIR_geCache_segments.txt (see BuildEngine::segmentSaveDone).  Batch builds keep their own
+  checkpoint file (see checkpoint.cpp) and won't start in a cache directory that an interrupted GUI build can still be resumed in.
+
+  Adding --queue puts the build in the job queue (see jobQueue.cpp) instead of running it.  --run-queue runs every job in the queue
+  that hasn't been done, one after another, and --list-queue and --clear-queue do what they say.  A job that was running when the
+  queue was interrupted is started over the next time the queue is run.
+
+  The progress is written to stdout, one line per event:
+
+      job JOB_NUMBER NAME
+      start BOXES ESTIMATED_SECONDS
+      progress BOX BOXES REMAINING_SECONDS CACHE_BYTES
+      copy FILES_DONE FILES BYTES_DONE BYTES
+      segment SEGMENT_DIR
+      error MESSAGE
+      job JOB_NUMBER done|failed EXIT_CODE
+      done EXIT_CODE
+
+  The exit code is one of the BATCH_ codes in geCacheDef.hpp.  For a queue it's the exit code of the last job that failed.
+*/
+
+
+static volatile sig_atomic_t batch_signal = 0;
+
+
+static void batchSignal (int sig)
+{
+  batch_signal = sig;
+}
+
+
+
+static void usage ()
+{
+  fprintf (stderr, "\nUsage: geCache --build AREA.kml|--build-rect SOUTH,WEST,NORTH,EAST --out SAVE_DIR [--box-size METERS] [--dwell SECONDS]\n");
+  fprintf (stderr, "               [--ge-name NAME] [--ge-dir DIR] [--queue]\n");
+  fprintf (stderr, "       geCache --run-queue [--ge-name NAME] [--ge-dir DIR]\n");
+  fprintf (stderr, "       geCache --list-queue\n");
+  fprintf (stderr, "       geCache --clear-queue\n\n");
+  fprintf (stderr, "Builds the Google Earth cache for the rectangle or polygon in AREA.kml without the GUI.  The cache is saved\n");
+  fprintf (stderr, "to SAVE_DIR_seg001, SAVE_DIR_seg002, ... (a new segment is started whenever the cache size limit is reached).\n\n");
+  fprintf (stderr, "    --box-size    Size of the areas displayed in Google Earth in meters (500 to 20000)\n");
+  fprintf (stderr, "    --dwell       Seconds to display each area (4 to 60)\n");
+  fprintf (stderr, "    --ge-name     Google Earth executable or script\n");
+  fprintf (stderr, "    --ge-dir      Google Earth cache directory\n");
+  fprintf (stderr, "    --queue       Add the build to the job queue instead of running it\n");
+  fprintf (stderr, "    --run-queue   Run the jobs in the queue that haven't been done\n");
+  fprintf (stderr, "    --list-queue  List the jobs in the queue\n");
+  fprintf (stderr, "    --clear-queue Remove all of the jobs from the queue\n\n");
+  fprintf (stderr, "Anything not given comes from the geCache settings.  Progress is written to stdout.\n\n");
+}
+
+
+
+//  Runs a batch build (called from main when --build is on the command line).
+
+int32_t batchBuild (int argc, char **argv)
+{
+  //  We don't create any widgets so we only need a QGuiApplication (for the font in OPTIONS), but that still wants a display
+  //  unless we give it the offscreen platform.  We pass it on the command line instead of setting QT_QPA_PLATFORM so that Google
+  //  Earth doesn't inherit it.
+
+  std::vector<char *> app_argv (argv, argv + argc);
+  char platform_arg[] = "-platform", platform_name[] = "offscreen";
+  app_argv.push_back (platform_arg);
+  app_argv.push_back (platform_name);
+  app_argv.push_back (NULL);
+  int app_argc = argc + 2;
+
+  QGuiApplication a (app_argc, app_argv.data ());
+
+
+  QStringList arguments;
+  for (int32_t i = 1 ; i < argc ; i++) arguments += QString::fromLocal8Bit (argv[i]);
+
+
+  BatchBuild batch;
+
+  int32_t ret = batch.start (arguments);
+
+  if (ret != BATCH_RUNNING) return (ret);
+
+  return (a.exec ());
+}
+
+
+
+BatchBuild::BatchBuild (QObject *parent):
+  QObject (parent)
+{
+  void set_defaults (MISC *misc, OPTIONS *options, uint8_t reset);
+  uint8_t envin (OPTIONS *options);
+
+
+  build_started = false;
+  build_finished = false;
+  build_errors = false;
+  save_failed = false;
+  exit_code = BATCH_OK;
+  copy_percent = -1;
+  queue_mode = false;
+  queue_exit_code = BATCH_OK;
+  job_index = -1;
+
+
+  //  Start with the user's settings (we never save them).
+
+  set_defaults (&misc, &options, false);
+  settings_ok = envin (&options);
+
+  misc.batch_run = true;
+
+
+  buildEngine = new BuildEngine (&options, &misc, this);
+  connect (buildEngine, SIGNAL (progress (int32_t, int32_t, int64_t)), this, SLOT (slotProgress (int32_t, int32_t, int64_t)));
+  connect (buildEngine, SIGNAL (copyProgress (int32_t, int32_t, int64_t, int64_t)), this, SLOT (slotCopyProgress (int32_t, int32_t, int64_t, int64_t)));
+  connect (buildEngine, SIGNAL (segmentSaved (const QString &, const QString &)), this, SLOT (slotSegmentSaved (const QString &, const QString &)));
+  connect (buildEngine, SIGNAL (saveFailed ()), this, SLOT (slotSaveFailed ()));
+  connect (buildEngine, SIGNAL (finished ()), this, SLOT (slotFinished ()));
+  connect (buildEngine, SIGNAL (stopped ()), this, SLOT (slotStopped ()));
+  connect (buildEngine, SIGNAL (error (const QString &)), this, SLOT (slotError (const QString &)));
+
+
+  //  Check for SIGINT and SIGTERM once a second so that we don't leave Google Earth running if we're killed.
+
+  signalTimer = new QTimer (this);
+  connect (signalTimer, SIGNAL (timeout ()), this, SLOT (slotCheckSignal ()));
+}
+
+
+
+/*!
+  Does whatever the command line arguments say.  Returns BATCH_RUNNING if a build is running (the exit code will be passed to
+  QCoreApplication::exit when it's done) or the exit code if we're already done.
+*/
+
+int32_t 
+BatchBuild::start (const QStringList &arguments)
+{
+  QString area_name, out_dir;
+  uint8_t add_to_queue = false, run_queue = false, list_queue = false, clear_queue = false;
+
+
+  if (!settings_ok)
+    {
+      report ("error Unable to allocate memory for the saved polygon in geCache.ini");
+      return (finish (BATCH_SETUP));
+    }
+
+
+  for (int32_t i = 0 ; i < arguments.size () ; i++)
+    {
+      QString arg = arguments.at (i);
+
+      if (arg == "--help" || arg == "-h")
+        {
+          usage ();
+          return (BATCH_USAGE);
+        }
+
+
+      //  These don't have values.
+
+      if (arg == "--queue")
+        {
+          add_to_queue = true;
+          continue;
+        }
+
+      if (arg == "--run-queue")
+        {
+          run_queue = true;
+          continue;
+        }
+
+      if (arg == "--list-queue")
+        {
+          list_queue = true;
+          continue;
+        }
+
+      if (arg == "--clear-queue")
+        {
+          clear_queue = true;
+          continue;
+        }
+
+
+      if (i == arguments.size () - 1)
+        {
+          fprintf (stderr, "geCache: %s needs a value\n", arg.toLocal8Bit ().constData ());
+          usage ();
+          return (BATCH_USAGE);
+        }
+
+      QString value = arguments.at (++i);
+      bool ok = true;
+
+      if (arg == "--build")
+        {
+          area_name = value;
+
+          if (!readAreaFile (value, &options))
+            {
+              report (QString ("error Unable to read an area from %1").arg (value));
+              return (finish (BATCH_SETUP));
+            }
+        }
+      else if (arg == "--build-rect")
+        {
+          QStringList bounds = value.split (",");
+          bool bounds_ok[4] = {false, false, false, false};
+
+          if (bounds.size () == 4)
+            {
+              options.cache_mbr.min_y = bounds.at (0).toDouble (&bounds_ok[0]);
+              options.cache_mbr.min_x = bounds.at (1).toDouble (&bounds_ok[1]);
+              options.cache_mbr.max_y = bounds.at (2).toDouble (&bounds_ok[2]);
+              options.cache_mbr.max_x = bounds.at (3).toDouble (&bounds_ok[3]);
+            }
+
+          ok = bounds_ok[0] && bounds_ok[1] && bounds_ok[2] && bounds_ok[3] && options.cache_mbr.min_y < options.cache_mbr.max_y &&
+            options.cache_mbr.min_x < options.cache_mbr.max_x;
+
+          options.shape_tab = RECT_TAB;
+          options.polygon.clear ();
+          area_name = "rectangle";
+        }
+      else if (arg == "--out")
+        {
+          out_dir = QFileInfo (value).absoluteFilePath ();
+        }
+      else if (arg == "--box-size")
+        {
+          options.build_box_size = value.toInt (&ok);
+          if (options.build_box_size < 500 || options.build_box_size > 20000) ok = false;
+        }
+      else if (arg == "--dwell")
+        {
+          options.cache_update_frequency = value.toInt (&ok);
+          if (options.cache_update_frequency < 4 || options.cache_update_frequency > 60) ok = false;
+        }
+      else if (arg == "--ge-name")
+        {
+          options.ge_name = value;
+        }
+      else if (arg == "--ge-dir")
+        {
+          options.ge_dir = value;
+        }
+      else
+        {
+          fprintf (stderr, "geCache: unknown option %s\n", arg.toLocal8Bit ().constData ());
+          usage ();
+          return (BATCH_USAGE);
+        }
+
+      if (!ok)
+        {
+          fprintf (stderr, "geCache: bad value %s for %s\n", value.toLocal8Bit ().constData (), arg.toLocal8Bit ().constData ());
+          usage ();
+          return (BATCH_USAGE);
+        }
+    }
+
+
+  //  Queue maintenance.
+
+  if (list_queue)
+    {
+      std::vector<BUILD_JOB> jobs;
+
+      if (!readJobQueue (&jobs))
+        {
+          report (QString ("error Unable to lock the job queue %1").arg (jobQueueName ()));
+          return (BATCH_SETUP);
+        }
+
+      for (uint32_t i = 0 ; i < jobs.size () ; i++)
+        {
+          report (QString ("job %1 %2 %3 %4 %5 %6 %7").arg (i + 1).arg (jobStatusText (jobs[i].status)).arg (jobs[i].exit_code).
+                  arg (jobs[i].box_size).arg (jobs[i].dwell).arg (jobs[i].out_dir).arg (jobs[i].name));
+        }
+
+      return (BATCH_OK);
+    }
+
+  if (clear_queue)
+    {
+      if (!clearJobQueue ())
+        {
+          report (QString ("error Unable to clear the job queue %1").arg (jobQueueName ()));
+          return (BATCH_SETUP);
+        }
+
+      return (BATCH_OK);
+    }
+
+
+  //  Everything from here on is run with these options (each job puts its own area, box size, and update frequency in).
+
+  base_options = options;
+
+
+  if (run_queue)
+    {
+      //  A job that was running when the queue was interrupted gets started over.
+
+      if (!resetJobQueue ())
+        {
+          report (QString ("error Unable to lock the job queue %1").arg (jobQueueName ()));
+          return (BATCH_SETUP);
+        }
+
+      queue_mode = true;
+
+      return (runNextJob ());
+    }
+
+
+  if (area_name.isEmpty () || out_dir.isEmpty ())
+    {
+      usage ();
+      return (BATCH_USAGE);
+    }
+
+
+  if (add_to_queue)
+    {
+      makeJob (&options, area_name, out_dir, &job);
+
+      std::vector<BUILD_JOB> jobs;
+
+      if (!addJob (&job) || !readJobQueue (&jobs))
+        {
+          report (QString ("error Unable to lock the job queue %1").arg (jobQueueName ()));
+          return (BATCH_SETUP);
+        }
+
+      report (QString ("job %1 %2").arg (jobs.size ()).arg (area_name));
+
+      return (BATCH_OK);
+    }
+
+
+  int32_t code = startBuild (out_dir);
+
+  if (code != BATCH_RUNNING) return (finish (code));
+
+  return (BATCH_RUNNING);
+}
+
+
+
+/*!
+  Starts a fresh, unattended build of the area in options that will be saved to out_dir (the segment base name).  Returns
+  BATCH_RUNNING if the build is running or the exit code if it couldn't be started.
+*/
+
+int32_t 
+BatchBuild::startBuild (const QString &out_dir)
+{
+  //  Make sure the Google Earth cache directory and the save directory are usable.
+
+  if (!QDir::isAbsolutePath (options.ge_dir) || !QFile (options.ge_dir).exists ())
+    {
+      report (QString ("error Google Earth cache directory %1 does not exist or is not a full path").arg (options.ge_dir));
+      return (BATCH_SETUP);
+    }
+
+  if (!QFileInfo (out_dir).absoluteDir ().exists ())
+    {
+      report (QString ("error Directory %1 does not exist").arg (QFileInfo (out_dir).absolutePath ()));
+      return (BATCH_SETUP);
+    }
+
+
+  //  A batch build starts by throwing away the cache directory (and the snapshot next to it).  If a build that was started from the
+  //  GUI was interrupted in the same cache directory that would throw away its resume point so we leave it alone.
+
+  QString gui_dir = checkpointCacheDir (false);
+
+  if (!gui_dir.isEmpty () && QDir::cleanPath (gui_dir) == QDir::cleanPath (options.ge_dir))
+    {
+      report (QString ("error An interrupted geCache build of %1 can still be resumed (see %2).  Resume or restart it in geCache, "
+                       "or use a different Google Earth cache directory.").arg (options.ge_dir).arg (checkpointName (false)));
+      return (BATCH_SETUP);
+    }
+
+
+  //  Finish removing any old cache directories that an earlier run didn't get to (see removeDir.cpp).
+
+  sweepTombstones (QFileInfo (options.ge_dir).absolutePath ());
+  sweepTombstones (QFileInfo (out_dir).absolutePath ());
+
+
+  //  Never build into a mounted saved cache.
+
+  if (cacheMounted (options.ge_dir) && !unmountCache (options.ge_dir))
+    {
+      report (QString ("error Unable to unmount the saved cache from %1").arg (options.ge_dir));
+      return (BATCH_SETUP);
+    }
+
+
+  //  A batch build always starts with an empty cache and saves it to numbered segments without asking.
+
+  options.incremental_build = false;
+  options.unattended_build = true;
+
+  removeDirLater (options.ge_dir);
+
+  clearCoverage (&misc.coverage);
+  writeCoverage (options.ge_dir, &misc.coverage);
+
+  misc.segment_base = out_dir;
+  misc.segment_number = 1;
+
+  QFile (misc.segment_base + "_geCache_segments.txt").remove ();
+
+
+  if (!computeSize (&misc, &options) || !setBuildPlan (&misc, &options))
+    {
+      report ("error Unable to allocate build plan memory");
+      return (BATCH_SETUP);
+    }
+
+  if (!misc.plan.box.size ())
+    {
+      report ("error There are no areas to be cached");
+      return (BATCH_SETUP);
+    }
+
+  report (QString ("start %1 %2").arg (misc.plan.box.size ()).arg (misc.poly_flag ? misc.total_poly_time : misc.total_rect_time));
+
+
+  signal (SIGINT, batchSignal);
+  signal (SIGTERM, batchSignal);
+
+  signalTimer->start (1000);
+
+
+  build_finished = false;
+  build_errors = false;
+  save_failed = false;
+  exit_code = BATCH_OK;
+
+  if (!buildEngine->start (false, 0, 0, QString ()))
+    {
+      signalTimer->stop ();
+      return (BATCH_GOOGLE_EARTH);
+    }
+
+  build_started = true;
+
+  return (BATCH_RUNNING);
+}
+
+
+
+/*!
+  Starts the next job in the queue that hasn't been done.  The queue is read again each time so that jobs that were added while
+  the last one was running get run too.  Jobs that can't be started are marked as failed and we go on to the next one.  Returns
+  BATCH_RUNNING if a job is running or, when there's nothing left to do, the exit code for the queue.
+*/
+
+int32_t 
+BatchBuild::runNextJob ()
+{
+  while ((job_index = startNextJob (&job)) >= 0)
+    {
+      //  Start each job from the same settings.
+
+      options = base_options;
+      setJobOptions (&job, &options);
+
+      report (QString ("job %1 %2").arg (job_index + 1).arg (job.name));
+
+      int32_t code = startBuild (job.out_dir);
+
+      if (code == BATCH_RUNNING) return (BATCH_RUNNING);
+
+      jobDone (code);
+    }
+
+  return (finish (queue_exit_code));
+}
+
+
+
+//  Record how the current job went.
+
+void 
+BatchBuild::jobDone (int32_t code)
+{
+  job.exit_code = code;
+  job.status = (code == BATCH_OK) ? JOB_DONE : JOB_FAILED;
+
+  if (code != BATCH_OK) queue_exit_code = code;
+
+
+  //  Only this job is changed (by id) so that jobs that were added while it was running aren't lost.
+
+  if (!updateJob (&job)) report (QString ("error Unable to update job %1 in the job queue %2").arg (job.name).arg (jobQueueName ()));
+
+  report (QString ("job %1 %2 %3").arg (job_index + 1).arg (jobStatusText (job.status)).arg (code));
+}
+
+
+
+//  Write one line of progress to stdout.
+
+void 
+BatchBuild::report (const QString &line)
+{
+  printf ("%s\n", line.toLocal8Bit ().constData ());
+  fflush (stdout);
+}
+
+
+
+//  Report the exit code and return it.
+
+int32_t 
+BatchBuild::finish (int32_t code)
+{
+  report (QString ("done %1").arg (code));
+
+  return (code);
+}
+
+
+
+void 
+BatchBuild::slotProgress (int32_t value, int32_t remaining, int64_t cache_size)
+{
+  copy_percent = -1;
+
+  report (QString ("progress %1 %2 %3 %4").arg (qMax (value, 0)).arg (misc.plan.box.size ()).arg (remaining).arg (cache_size));
+}
+
+
+
+//  Only report the segment copy when the percentage changes.
+
+void 
+BatchBuild::slotCopyProgress (int32_t files_done, int32_t total_files, int64_t bytes_done, int64_t total_bytes)
+{
+  int32_t percent = total_bytes ? (int32_t) (bytes_done * 100 / total_bytes) : 0;
+
+  if (percent == copy_percent) return;
+
+  copy_percent = percent;
+
+  report (QString ("copy %1 %2 %3 %4").arg (files_done).arg (total_files).arg (bytes_done).arg (total_bytes));
+}
+
+
+
+void 
+BatchBuild::slotSegmentSaved (const QString &segment, const QString &stats ATTR_UNUSED)
+{
+#ifdef _MSC_VER
+UNREFERENCED_PARAMETER (stats);
+#endif
+
+  report (QString ("segment %1").arg (segment));
+}
+
+
+
+void 
+BatchBuild::slotFinished ()
+{
+  build_finished = true;
+}
+
+
+
+//  The build engine sends stopped before finished so we wait until it's done with both before we figure out the exit code.  If
+//  Google Earth didn't start, startBuild takes care of it.
+
+void 
+BatchBuild::slotStopped ()
+{
+  if (!build_started) return;
+
+  build_started = false;
+
+  signalTimer->stop ();
+
+  QTimer::singleShot (0, this, SLOT (slotExit ()));
+}
+
+
+
+void 
+BatchBuild::slotError (const QString &message)
+{
+  build_errors = true;
+
+  report ("error " + message);
+}
+
+
+
+void 
+BatchBuild::slotSaveFailed ()
+{
+  save_failed = true;
+}
+
+
+
+void 
+BatchBuild::slotExit ()
+{
+  //  A segment that couldn't be saved stops the build before it finishes so we have to check for that before we blame Google Earth.
+
+  if (exit_code == BATCH_OK)
+    {
+      if (save_failed)
+        {
+          exit_code = BATCH_SAVE;
+        }
+      else if (!build_finished)
+        {
+          exit_code = BATCH_GOOGLE_EARTH;
+        }
+      else if (build_errors)
+        {
+          exit_code = BATCH_SAVE;
+        }
+    }
+
+
+  if (queue_mode)
+    {
+      //  If we were killed, leave the job to be started over the next time the queue is run.
+
+      if (exit_code == BATCH_INTERRUPTED)
+        {
+          job.status = JOB_PENDING;
+          updateJob (&job);
+
+          QCoreApplication::exit (finish (exit_code));
+          return;
+        }
+
+      jobDone (exit_code);
+
+      int32_t code = runNextJob ();
+
+      if (code != BATCH_RUNNING) QCoreApplication::exit (code);
+
+      return;
+    }
+
+
+  QCoreApplication::exit (finish (exit_code));
+}
+
+
+
+//  We were told to quit.  Shut down Google Earth before we go.
+
+void 
+BatchBuild::slotCheckSignal ()
+{
+  if (!batch_signal) return;
+
+  report (QString ("error Interrupted by signal %1").arg ((int32_t) batch_signal));
+
+  exit_code = BATCH_INTERRUPTED;
+
+  buildEngine->stop ();
+}
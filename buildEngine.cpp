@@ -0,0 +1,1131 @@
+
+/********************************************************************************************* 
+
+    buildEngine.cpp
+
+    Copyright (c) 2016, Jan C. Depner
+
+
+    This file is part of geCache.
+
+    geCache is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    geCache is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with geCache.  If not, see <http://www.gnu.org/licenses/>.
+
+*********************************************************************************************/
+
+
+
+#include "geCacheEngine.hpp"
+
+
+/*!
+  The BuildEngine runs a cache build.  It starts Google Earth on a network link KML file, walks Google Earth through the boxes in
+  the build plan (misc->plan, see buildPlan.cpp) by rewriting the file that the network link points to, keeps track of the cache
+  size, puts the cache back the way it was when it gets too big, and keeps the checkpoint up to date.  It doesn't know anything
+  about the GUI.  Everything that the user needs to know about (or answer) is sent out as a signal so the build can be driven by
+  the geCache window or from the command line.  The OPTIONS and MISC structures belong to whoever created the engine.
+
+  The build goes through these states (driven by a 500 millisecond timer so that nothing ever blocks while we wait):
+
+  - BUILD_STARTING - Google Earth has been started.  Once it has set up its cache we snapshot the cache directory.
+  - BUILD_SETTLING - Waiting for Google Earth to be ready (see googleEarthReady.cpp) and for the background scan of the cache
+                     directory (see startCacheScan) before we display the first box.
+  - BUILD_VISITING - Displaying the boxes in the plan (see dwellDone and visitNextBox).
+  - BUILD_SAVING - An unattended build is copying the full cache to the next segment (see startSegmentSave).  Google Earth stays
+                   where it is until the copy is done (see segmentSaveDone).
+  - BUILD_FINAL_OVERVIEW - The entire area is being displayed (see finalOverviewDone).
+  - BUILD_DRAINING - Waiting for any background work on the cache directory to finish before finishBuild wraps up.
+  - BUILD_DONE - No build is running.
+*/
+
+BuildEngine::BuildEngine (OPTIONS *op, MISC *mi, QObject *parent):
+  QObject (parent)
+{
+  options = op;
+  misc = mi;
+
+  geProc = NULL;
+  cache_sizer = NULL;
+  segment_copy = NULL;
+  segment_final = false;
+  build_index = 0;
+  coverage_start = 0;
+  build_kill_flag = false;
+  build_state = BUILD_DONE;
+  build_state_timestamp = 0;
+  cache_activity_timestamp = 0;
+  start_timestamp = 0;
+
+
+  timer = new QTimer (this);
+  connect (timer, SIGNAL (timeout ()), this, SLOT (slotTimer ()));
+
+
+  //  The cache watcher lets us know when Google Earth writes to the cache directory (for adaptive dwell, see dwellDone).
+
+  cacheWatcher = new QFileSystemWatcher (this);
+  connect (cacheWatcher, SIGNAL (directoryChanged (const QString &)), this, SLOT (slotCacheActivity (const QString &)));
+  connect (cacheWatcher, SIGNAL (fileChanged (const QString &)), this, SLOT (slotCacheActivity (const QString &)));
+}
+
+
+
+BuildEngine::~BuildEngine ()
+{
+  if (geProc) stop ();
+}
+
+
+
+//  Returns true if a build is running.
+
+uint8_t 
+BuildEngine::running ()
+{
+  return (geProc && geProc->state () == QProcess::Running);
+}
+
+
+
+//  Stop (or restart) the build timer.  This is used to keep the build from moving while the cache is being copied.
+
+void 
+BuildEngine::pause (uint8_t paused)
+{
+  if (!geProc) return;
+
+  if (paused)
+    {
+      timer->stop ();
+    }
+  else
+    {
+      timer->start (500);
+    }
+}
+
+
+
+/*!
+  Start (or resume) the build.  The build plan has to have been made (see setBuildPlan).  The build starts at plan box start_index
+  and the boxes from start_coverage on are the ones that have been added to the cache since it was last restored from the
+  snapshot.  If we're resuming and the snapshot from the original build is still there we'll use it.  Returns false (after sending
+  an error) if Google Earth couldn't be started.
+*/
+
+uint8_t 
+BuildEngine::start (uint8_t resume, int32_t start_index, int32_t start_coverage, const QString &snapshot)
+{
+  FILE *fp;
+
+
+  build_index = start_index;
+  coverage_start = start_coverage;
+  build_kill_flag = false;
+
+
+  QString tmp0 = QDir::tempPath () + SEPARATOR + QString ("geCache_GE_%1_tmp_build_link.kml").arg (misc->process_id);
+  QString tmp1 = QDir::tempPath () + SEPARATOR + QString ("geCache_GE_%1_tmp_build_look.kml").arg (misc->process_id);
+
+
+  //  Get the full path names.
+
+  strcpy (ge_tmp_name[0], QFileInfo (tmp0).absoluteFilePath ().toLatin1 ());
+  strcpy (ge_tmp_name[1], QFileInfo (tmp1).absoluteFilePath ().toLatin1 ());
+
+
+  if ((fp = fopen (ge_tmp_name[0], "w")) == NULL)
+    {
+      emit error (tr ("Unable to open temporary Google Earth link file!"));
+      return (false);
+    }
+
+
+  //  Build the "look at" file.
+
+  if (positionGoogleEarth ())
+    {
+      fclose (fp);
+      remove (ge_tmp_name[0]);
+      return (false);
+    }
+
+
+  fprintf (fp, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  fprintf (fp, "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n");
+  fprintf (fp, "  <NetworkLink>\n");
+  fprintf (fp, "    <name>NetworkLink</name>\n");
+  fprintf (fp, "    <flyToView>1</flyToView>\n");
+  fprintf (fp, "    <Link>\n");
+  fprintf (fp, "      <href>%s</href>\n", ge_tmp_name[1]);
+  fprintf (fp, "      <refreshMode>onInterval</refreshMode>\n");
+
+
+  //  With adaptive dwell we may move on well before the update frequency so we want Google Earth to check for the next box every second.
+
+  fprintf (fp, "      <refreshInterval>%d</refreshInterval>\n", options->adaptive_dwell ? 1 : options->cache_update_frequency);
+  fprintf (fp, "    </Link>\n");
+  fprintf (fp, "  </NetworkLink>\n");
+  fprintf (fp, "</kml>\n");
+
+  fclose (fp);
+
+
+  QStringList arguments;
+  arguments << QString (ge_tmp_name[0]);
+
+
+  geProc = new QProcess (this);
+
+  connect (geProc, SIGNAL (error (QProcess::ProcessError)), this, SLOT (slotGoogleEarthError (QProcess::ProcessError)));
+  connect (geProc, SIGNAL (finished (int, QProcess::ExitStatus)), this, SLOT (slotGoogleEarthDone (int, QProcess::ExitStatus)));
+
+
+  //  Start watching for Google Earth to read the network link file before it has a chance to.
+
+  startReadyCheck (&misc->ge_ready, ge_tmp_name[1]);
+
+
+  geProc->start (options->ge_name, arguments);
+
+  geProc->waitForStarted ();
+
+
+  //  If Google Earth didn't start, slotGoogleEarthError has already cleaned up.
+
+  if (!geProc) return (false);
+
+  misc->second_count = 0;
+
+  watchCache ();
+  resetCacheSize (&misc->cache_size, options->ge_dir);
+  startCacheScan ();
+  start_timestamp = cache_activity_timestamp;
+
+
+  //  We need a snapshot of the newly created cache directory in case we max out the current one.  The build timer will take it
+  //  (see snapshotCache) once Google Earth has had a few seconds to get going.
+
+  cache_snapshot = resume ? snapshot : QString ();
+
+  setBuildState (BUILD_STARTING);
+
+  timer->start (500);
+
+  return (true);
+}
+
+
+
+//  This kills the Google Earth process and removes the temporary KML files.
+
+void 
+BuildEngine::stop ()
+{
+  if (!geProc) return;
+
+
+  timer->stop ();
+
+
+#ifdef _MSC_VER
+
+  //  On Windows, Google Earth is a normal application so we can use the normal "kill" to get rid of it.
+
+  if (geProc->state () == QProcess::Running)
+    {
+      disconnect (geProc, SIGNAL (error (QProcess::ProcessError)), this, SLOT (slotGoogleEarthError (QProcess::ProcessError)));
+      disconnect (geProc, SIGNAL (finished (int, QProcess::ExitStatus)), this, SLOT (slotGoogleEarthDone (int, QProcess::ExitStatus)));
+
+      geProc->kill ();
+    }
+
+
+#else
+
+
+  //  On Linux, Google Earth is run from a script so we can't use the normal "kill" technique because all we'll kill that way will be the script.
+  //  That leaves Google Earth still running.  What we need to do on Linux is to find the Google Earth script that belongs to the current user,
+  //  find its child, and kill that.
+
+  if (geProc->state () == QProcess::Running)
+    {
+      disconnect (geProc, SIGNAL (error (QProcess::ProcessError)), this, SLOT (slotGoogleEarthError (QProcess::ProcessError)));
+      disconnect (geProc, SIGNAL (finished (int, QProcess::ExitStatus)), this, SLOT (slotGoogleEarthDone (int, QProcess::ExitStatus)));
+
+      Q_PID pid = geProc->pid ();
+      QProcess killer;
+      QStringList params;
+      params << "--ppid";
+      params << QString::number (pid);
+      params << "-o";
+      params << "pid";
+      params << "--noheaders";
+      killer.start ("/bin/ps", params, QIODevice::ReadOnly);
+
+      if (killer.waitForStarted (-1))
+        { 
+          if (killer.waitForFinished (-1))
+            {
+              QByteArray temp = killer.readAllStandardOutput ();
+              QString str = QString::fromLocal8Bit (temp);
+              QStringList list = str.split ("\n");
+
+              for (int32_t i = 0 ; i < list.size () ; i++)
+                {
+                  if (!list.at (i).isEmpty ()) kill (list.at (i).toInt (), SIGKILL);
+                }
+            }
+        }
+
+
+      //  Now kill the script (this probably isn't necessary).
+
+      geProc->kill ();
+    }
+
+#endif
+
+  delete (geProc);
+
+  geProc = NULL;
+
+
+  //  If we were saving a segment, cancel the copy (the partial segment is removed, the cache directory is left alone).
+
+  if (segment_copy)
+    {
+      delete (segment_copy);
+      segment_copy = NULL;
+    }
+
+
+  //  Stop watching the cache directory.
+
+  if (!cacheWatcher->directories ().isEmpty ()) cacheWatcher->removePaths (cacheWatcher->directories ());
+  if (!cacheWatcher->files ().isEmpty ()) cacheWatcher->removePaths (cacheWatcher->files ());
+
+  build_index = 0;
+  build_kill_flag = false;
+  setBuildState (BUILD_DONE);
+  stopReadyCheck (&misc->ge_ready);
+
+
+  remove (ge_tmp_name[0]);
+  remove (ge_tmp_name[1]);
+
+
+  //  Get rid of the cache snapshot directory unless the build didn't finish (we'll need it if the build is resumed).
+
+  if (!QFileInfo (checkpointName (misc->batch_run)).exists () && !cache_snapshot.isEmpty ()) removeDirLater (cache_snapshot);
+
+
+  emit stopped ();
+}
+
+
+
+//  Build timer - move the build along (see the states at the top of this file).
+
+void 
+BuildEngine::slotTimer ()
+{
+  if (!running ()) return;
+
+
+  switch (build_state)
+    {
+    case BUILD_STARTING:
+
+      //  Take the snapshot once Google Earth has set up its cache (it has written to the cache directory and then paused for
+      //  a second, or it has been writing for a while).  If it never writes anything we go ahead after GE_START_TIMEOUT.
+
+      if (buildStateTime () >= GE_START_TIMEOUT || (cache_activity_timestamp > build_state_timestamp &&
+                                                     (QDateTime::currentMSecsSinceEpoch () - cache_activity_timestamp >= 1000 ||
+                                                      buildStateTime () >= GE_START_MIN)))
+        {
+          snapshotCache ();
+          setBuildState (BUILD_SETTLING);
+        }
+      break;
+
+
+    case BUILD_SETTLING:
+
+      //  Start on the boxes once Google Earth has read the network link file and settled down (see googleEarthReady.cpp).  Where
+      //  we can't watch the KML file for reads, a write to the cache directory since Google Earth started means it has read it.
+
+      {
+        uint8_t kml_read = kmlRead (&misc->ge_ready, ge_tmp_name[1]) || cache_activity_timestamp > start_timestamp;
+        uint8_t settled = googleEarthSettled (&misc->ge_ready, (int64_t) geProc->pid (), cache_activity_timestamp,
+                                              (int64_t) options->dwell_settle * 1000);
+
+        if (misc->cache_size.sized && ((kml_read && settled) || buildStateTime () >= GE_READY_TIMEOUT))
+          {
+            stopReadyCheck (&misc->ge_ready);
+            setBuildState (BUILD_VISITING);
+            visitNextBox ();
+          }
+      }
+      break;
+
+
+    case BUILD_VISITING:
+
+      //  After the snapshot has been put back we have to wait for the cache to be sized again.
+
+      if (misc->cache_size.sized && dwellDone ()) visitNextBox ();
+      break;
+
+
+    case BUILD_SAVING:
+
+      if (segment_copy->wait (0))
+        {
+          segmentSaveDone ();
+        }
+      else
+        {
+          emit copyProgress (segment_copy->files_done.load (), segment_copy->total_files, segment_copy->bytes_done.load (),
+                             segment_copy->total_bytes);
+        }
+      break;
+
+
+    case BUILD_FINAL_OVERVIEW:
+
+      if (finalOverviewDone ()) setBuildState (BUILD_DRAINING);
+      break;
+
+
+    case BUILD_DRAINING:
+
+      //  Don't finish up while the cache is still being sized in the background.
+
+      if (!cache_sizer) finishBuild ();
+      break;
+    }
+
+  misc->second_count++;
+}
+
+
+
+void 
+BuildEngine::setBuildState (int32_t state)
+{
+  build_state = state;
+  build_state_timestamp = QDateTime::currentMSecsSinceEpoch ();
+}
+
+
+
+//  Milliseconds since the build went into its current state.
+
+int64_t 
+BuildEngine::buildStateTime ()
+{
+  return (QDateTime::currentMSecsSinceEpoch () - build_state_timestamp);
+}
+
+
+
+//  Size the whole cache directory in the background (see cacheSize.cpp).  If a scan is already running slotCacheSized will start
+//  another one when it's done if that one turns out to be out of date.
+
+void 
+BuildEngine::startCacheScan ()
+{
+  if (cache_sizer) return;
+
+  cache_sizer = new DirSizer (misc->cache_size.cache_dir);
+  connect (cache_sizer, SIGNAL (sized ()), this, SLOT (slotCacheSized ()));
+  QThreadPool::globalInstance ()->start (cache_sizer);
+}
+
+
+
+//  Takes the snapshot of the newly created cache directory that we'll put back if we max out the current one (unless we're using
+//  the one from the build that we're resuming).
+
+void 
+BuildEngine::snapshotCache ()
+{
+  if (cache_snapshot.isEmpty () || !QDir (cache_snapshot).exists ())
+    {
+      QDir cache_parent = QFileInfo (options->ge_dir).absoluteDir ();
+
+      cache_snapshot = cache_parent.absolutePath () + SEPARATOR + "cache_snapshot";
+
+      removeDirLater (cache_snapshot);
+
+      snapshotDir (options->ge_dir, cache_snapshot);
+    }
+
+
+  writeCheckpoint (options, misc, build_index, coverage_start, cache_snapshot);
+}
+
+
+
+/*!
+  Check the cache size, report the progress, and display the next box (or the whole area after the last box).  If the cache is
+  full (or the next box will probably fill it) an unattended build starts saving it to the next segment and carries on once the
+  copy is done (see segmentSaveDone).  Otherwise we send cacheFull and whoever gets it saves the cache (or stops the build).  Either
+  way, the snapshot is put back before the next box is displayed.
+*/
+
+void 
+BuildEngine::visitNextBox ()
+{
+  misc->second_count = -1;
+
+
+  //  Every few minutes we size the whole cache in the background to catch anything the cache watcher missed.
+
+  if (cacheSizeRescanDue (&misc->cache_size)) startCacheScan ();
+
+  int64_t cache_size = cacheSize (&misc->cache_size);
+
+
+  //  Project the cache size after the next box from the growth over the last few boxes.
+
+  addCacheSizeHistory (&misc->cache_size, cache_size);
+
+  int64_t limit = (int64_t) options->cache_size_limit * 1048576;
+
+
+  //  We're too close to the max cache size (or the next box will probably push us over it).
+
+  if (cache_size >= limit || projectCacheSize (&misc->cache_size) >= limit)
+    {
+      if (options->unattended_build)
+        {
+          //  If the segment couldn't be saved we stop instead of throwing away the cache (and what's in it).
+
+          if (!startSegmentSave (false)) segmentFailed ();
+          return;
+        }
+
+      emit cacheFull ();
+
+
+      //  Whoever got the signal may have stopped the build.
+
+      if (!geProc) return;
+
+      restartFromSnapshot ();
+      cache_size = cacheSize (&misc->cache_size);
+    }
+
+
+  showNextBox (cache_size);
+}
+
+
+
+//  Report the progress and display the next box (or the whole area after the last box).
+
+void 
+BuildEngine::showNextBox (int64_t cache_size)
+{
+  int32_t remaining = ((int32_t) misc->plan.box.size () - build_index + 3) * options->cache_update_frequency;
+
+
+  //  Wait twice the update frequency with the box reset to the whole area.
+
+  if (build_kill_flag || remaining <= 0) remaining = 2 * options->cache_update_frequency;
+
+  emit progress (build_index - 1, remaining, cache_size);
+
+
+  positionGoogleEarth ();
+
+
+  //  Save where we are in case Google Earth (or the machine) dies before we're done.
+
+  if (!build_kill_flag) writeCheckpoint (options, misc, build_index, coverage_start, cache_snapshot);
+
+
+  //  If positionGoogleEarth set the kill flag (we've passed the last box) we display the entire area for a while.
+
+  if (build_kill_flag)
+    {
+      //  This will position the view over the entire area.
+
+      positionGoogleEarth ();
+
+      emit progress ((misc->poly_flag ? misc->poly_iterations : misc->iterations) - 1, remaining, cache_size);
+
+      setBuildState (BUILD_FINAL_OVERVIEW);
+    }
+}
+
+
+
+/*!
+  We give Google Earth up to twice the update frequency with the entire area displayed.  If the cache stops changing before that
+  (after at least one update period, or the minimum dwell time with adaptive dwell) there's no point in waiting any longer.
+*/
+
+uint8_t 
+BuildEngine::finalOverviewDone ()
+{
+  int64_t elapsed = buildStateTime ();
+
+  if (elapsed >= (int64_t) options->cache_update_frequency * 2000) return (true);
+
+  int64_t min_wait = (int64_t) (options->adaptive_dwell ? options->dwell_min : options->cache_update_frequency) * 1000;
+
+  if (elapsed < min_wait) return (false);
+
+  int64_t quiet = QDateTime::currentMSecsSinceEpoch () - cache_activity_timestamp;
+
+  return (quiet >= (int64_t) options->dwell_settle * 1000);
+}
+
+
+
+//  The build is done.  An unattended build saves whatever is left to the last segment first (completeBuild is called once the
+//  copy is done).
+
+void 
+BuildEngine::finishBuild ()
+{
+  if (options->unattended_build)
+    {
+      build_index = (int32_t) misc->plan.box.size ();
+
+      if (!startSegmentSave (true)) segmentFailed ();
+      return;
+    }
+
+  completeBuild ();
+}
+
+
+
+//  Update the coverage index, shut down Google Earth, and let everyone know.
+
+void 
+BuildEngine::completeBuild ()
+{
+  //  Add the boxes that are in the cache now to the coverage index.  If we run out of memory the cache is still fine, the index
+  //  just won't know about some of it.
+
+  if (!addCoverage (&misc->coverage, &misc->plan, coverage_start, (int32_t) misc->plan.box.size ()))
+    emit error (tr ("Unable to allocate coverage index memory!  The coverage index for %1 is incomplete.").arg (options->ge_dir));
+
+  writeCoverage (options->ge_dir, &misc->coverage);
+
+
+  //  We're done so there's nothing to resume.
+
+  removeCheckpoint (misc);
+
+  stop ();
+
+  emit finished ();
+}
+
+
+
+/*!
+  A segment of an unattended build couldn't be saved.  The Google Earth cache is left alone (along with the checkpoint and the
+  snapshot) and the build is stopped so that the cache can be saved by hand or the build resumed once the problem is fixed.  We send
+  saveFailed before stopping so that whoever started the build can tell this apart from Google Earth dying.
+*/
+
+void 
+BuildEngine::segmentFailed ()
+{
+  if (!geProc) return;
+
+  emit error (tr ("The cache build has been stopped because the cache couldn't be saved.  The Google Earth cache directory %1 "
+                  "has not been changed.").arg (options->ge_dir));
+
+  emit saveFailed ();
+
+  stop ();
+}
+
+
+
+/*!
+  Starts saving the Google Earth cache to the next segment directory of an unattended build (SEGMENT_BASE_seg001, SEGMENT_BASE_seg002,
+  ...).  A segment directory that is already there is never overwritten, we just go on to the next number.  The copy runs in the
+  background while the build sits in BUILD_SAVING (the copy progress is sent out with copyProgress).  Set final if this is the last
+  segment of the build.  Returns false (after sending an error) if the copy couldn't be started.
+*/
+
+uint8_t 
+BuildEngine::startSegmentSave (uint8_t final)
+{
+  QString segment = misc->segment_base + QString ("_seg%1").arg (misc->segment_number, 3, 10, zero);
+
+  while (QFileInfo (segment).exists ())
+    {
+      misc->segment_number++;
+      segment = misc->segment_base + QString ("_seg%1").arg (misc->segment_number, 3, 10, zero);
+    }
+
+
+  segment_copy = new CopyEngine (options->ge_dir, segment, options->copy_bandwidth_limit);
+
+  if (!segment_copy->start ())
+    {
+      delete (segment_copy);
+      segment_copy = NULL;
+
+      emit error (tr ("Unable to copy %1 to %2").arg (options->ge_dir).arg (segment));
+      return (false);
+    }
+
+  segment_dir = segment;
+  segment_final = final;
+
+  setBuildState (BUILD_SAVING);
+
+  return (true);
+}
+
+
+
+/*!
+  The segment copy is done.  Save the coverage index (with the boxes visited since coverage_start) and the area file with the segment
+  and add a line to the segment manifest (SEGMENT_BASE_geCache_segments.txt).  Each line of the manifest has the segment directory
+  name, the first and last (plus one) plan box in the segment, and the bounds of those boxes, so that you can tell which segment to
+  load for any part of the area.  After that we either wrap up the build or put the snapshot back and display the next box.
+*/
+
+void 
+BuildEngine::segmentSaveDone ()
+{
+  CopyEngine *copy = segment_copy;
+  segment_copy = NULL;
+
+  if (!copy->succeeded ())
+    {
+      delete (copy);
+
+      emit error (tr ("Unable to copy %1 to %2").arg (options->ge_dir).arg (segment_dir));
+      segmentFailed ();
+      return;
+    }
+
+  QString stats = copyStatsText (&copy->stats);
+
+  delete (copy);
+
+
+  COVERAGE_INDEX saved_coverage = misc->coverage;
+
+  if (!addCoverage (&saved_coverage, &misc->plan, coverage_start, build_index))
+    emit error (tr ("Unable to allocate coverage index memory!  The coverage index for %1 is incomplete.").arg (segment_dir));
+
+  writeCoverage (segment_dir, &saved_coverage);
+
+  writeAreaFile (segment_dir, options);
+
+
+  NV_F64_XYMBR mbr;
+  mbr.min_x = mbr.min_y = 999.0;
+  mbr.max_x = mbr.max_y = -999.0;
+
+  int32_t end = qMin (build_index, (int32_t) misc->plan.box.size ());
+
+  for (int32_t i = coverage_start ; i < end ; i++)
+    {
+      mbr.min_x = qMin (mbr.min_x, misc->plan.box[i].mbr.min_x);
+      mbr.max_x = qMax (mbr.max_x, misc->plan.box[i].mbr.max_x);
+      mbr.min_y = qMin (mbr.min_y, misc->plan.box[i].mbr.min_y);
+      mbr.max_y = qMax (mbr.max_y, misc->plan.box[i].mbr.max_y);
+    }
+
+
+  FILE *fp;
+  char fname[1024];
+  strcpy (fname, QString (misc->segment_base + "_geCache_segments.txt").toLatin1 ());
+
+  uint8_t new_file = !QFileInfo (QString (fname)).exists ();
+
+  if ((fp = fopen (fname, "a")) != NULL)
+    {
+      if (new_file) fprintf (fp, "# geCache segment manifest - segment, first box, last box + 1, south, west, north, east\n");
+
+      fprintf (fp, "%s %d %d %.11f %.11f %.11f %.11f\n", QFileInfo (segment_dir).fileName ().toLatin1 ().constData (), coverage_start, end,
+               mbr.min_y, mbr.min_x, mbr.max_y, mbr.max_x);
+
+      fclose (fp);
+    }
+
+  misc->segment_number++;
+
+  emit segmentSaved (segment_dir, stats);
+
+
+  //  Whoever got the signal may have stopped the build.
+
+  if (!geProc) return;
+
+  if (segment_final)
+    {
+      completeBuild ();
+      return;
+    }
+
+  restartFromSnapshot ();
+  setBuildState (BUILD_VISITING);
+  showNextBox (cacheSize (&misc->cache_size));
+}
+
+
+
+/*!
+  Put the snapshot back in place of the full Google Earth cache directory (after it has been saved) and back up to the restart box
+  (the first box of the current row in serpentine order) because we're going to do those boxes again.  The cache is back to what it
+  was when the build started so only the boxes from here on will be in it.
+*/
+
+void 
+BuildEngine::restartFromSnapshot ()
+{
+  restoreSnapshot ();
+  watchCache ();
+  resetCacheSize (&misc->cache_size, options->ge_dir);
+  startCacheScan ();
+
+  if (build_index < (int32_t) misc->plan.box.size ()) build_index = misc->plan.box[build_index].restart;
+
+  coverage_start = build_index;
+}
+
+
+
+/*!
+  Adds the Google Earth cache directory, all of its subdirectories, and the files that Google Earth keeps writing to (the dbCache
+  files and the leveldb logs and manifests) to the cache watcher.  We don't watch every file since a cache can hold tens of
+  thousands of them.  New files show up as directory changes (see slotCacheActivity).
+*/
+
+void 
+BuildEngine::watchCache ()
+{
+  QStringList dirs, files;
+  QStringList filters;
+  filters << "dbCache*" << "*.log" << "MANIFEST-*";
+
+
+  if (!QDir (options->ge_dir).exists ()) return;
+
+  dirs += options->ge_dir;
+
+  QDirIterator dir_it (options->ge_dir, QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden, QDirIterator::Subdirectories);
+  while (dir_it.hasNext ()) dirs += dir_it.next ();
+
+  for (int32_t i = 0 ; i < dirs.size () ; i++)
+    {
+      QFileInfoList list = QDir (dirs.at (i)).entryInfoList (filters, QDir::Files | QDir::Hidden);
+
+      for (int32_t j = 0 ; j < list.size () ; j++) files += list.at (j).absoluteFilePath ();
+    }
+
+
+  //  QFileSystemWatcher complains about paths that are already being watched.
+
+  QStringList watched = cacheWatcher->directories () + cacheWatcher->files ();
+  QStringList paths = dirs + files;
+
+  for (int32_t i = paths.size () - 1 ; i >= 0 ; i--)
+    {
+      if (watched.contains (paths.at (i))) paths.removeAt (i);
+    }
+
+  if (!paths.isEmpty ()) cacheWatcher->addPaths (paths);
+
+
+  cache_activity_timestamp = QDateTime::currentMSecsSinceEpoch ();
+}
+
+
+
+/*!
+  Replaces the Google Earth cache directory with the snapshot that was taken when the build started.  Instead of deleting the
+  cache and copying the snapshot back into it we make a new snapshot from the old one (with snapshotDir, so this is mostly hard
+  links and reflinks) and swap the old snapshot in for the cache (see swapDir).  The old cache is removed in the background.  If
+  a rename fails (e.g. on Windows when Google Earth has a file open) we fall back to removing the cache and copying the snapshot.
+*/
+
+void 
+BuildEngine::restoreSnapshot ()
+{
+  QString next_snapshot = cache_snapshot + "_next";
+  QString old_cache = tombstoneName (options->ge_dir);
+
+
+  //  The watcher follows the directories, not the names, so it has to let go of the old cache before we move it.
+
+  QStringList watched = cacheWatcher->directories () + cacheWatcher->files ();
+  if (!watched.isEmpty ()) cacheWatcher->removePaths (watched);
+
+
+  removeDirLater (next_snapshot);
+
+  if (snapshotDir (cache_snapshot, next_snapshot) && swapDir (cache_snapshot, options->ge_dir, old_cache))
+    {
+      QDir ().rename (next_snapshot, cache_snapshot);
+      removeDirLater (old_cache);
+      return;
+    }
+
+  removeDirLater (next_snapshot);
+
+
+  removeDirLater (options->ge_dir);
+
+  copyDir (cache_snapshot, options->ge_dir);
+}
+
+
+
+/*!
+  Google Earth wrote to (or created or removed a file in) the cache directory.  If a directory changed we add any new
+  subdirectories or dbCache/leveldb files to the watcher.  The cache size tracker is told which directory needs to be sized
+  again.
+*/
+
+void 
+BuildEngine::slotCacheActivity (const QString &path)
+{
+  cache_activity_timestamp = QDateTime::currentMSecsSinceEpoch ();
+
+  cacheSizeChanged (&misc->cache_size, path);
+
+  if (QFileInfo (path).isDir ()) watchCache ();
+}
+
+
+
+/*!
+  The background scan of the cache directory has finished.  If we're still building (and still looking at the same directory) the
+  results replace the cache size tracker's directory sizes.
+*/
+
+void 
+BuildEngine::slotCacheSized ()
+{
+  if (geProc && cache_sizer->path == misc->cache_size.cache_dir)
+    rescanCacheSize (&misc->cache_size, &cache_sizer->dir_files, cache_sizer->timestamp);
+
+  cache_sizer->deleteLater ();
+  cache_sizer = NULL;
+
+
+  //  If the cache was reset while this scan was running its results were no good so we need another one.
+
+  if (geProc && !misc->cache_size.sized) startCacheScan ();
+}
+
+
+
+/*!
+  Returns true when it's time to move to the next box.  Normally that's after the cache update frequency.  With adaptive dwell
+  we move on as soon as Google Earth hasn't written to the cache for the settle time, but never before the minimum dwell time
+  (so that Google Earth has had time to pick up the new box and start loading it) and never after the cache update frequency.
+*/
+
+uint8_t 
+BuildEngine::dwellDone ()
+{
+  int32_t seconds = misc->second_count / 2;
+
+  if (seconds >= options->cache_update_frequency) return (true);
+
+  if (!options->adaptive_dwell || seconds < options->dwell_min) return (false);
+
+  int64_t quiet = QDateTime::currentMSecsSinceEpoch () - cache_activity_timestamp;
+
+  return (quiet >= (int64_t) options->dwell_settle * 1000);
+}
+
+
+
+//  Write the box that Google Earth should display next to the file that the network link points to.
+
+uint8_t 
+BuildEngine::positionGoogleEarth ()
+{
+  NV_F64_XYMBR actual_mbr;
+  FILE *fp;
+
+
+  //  Last time through we want to show the entire area.
+
+  if (build_kill_flag)
+    {
+      actual_mbr = misc->build_area_mbr;
+    }
+  else
+    {
+      misc->view_area_mbr = misc->plan.box[build_index].mbr;
+
+      actual_mbr.min_x = misc->view_area_mbr.min_x + misc->plan.box[build_index].x_border;
+      actual_mbr.max_x = misc->view_area_mbr.max_x - misc->plan.box[build_index].x_border;
+      actual_mbr.min_y = misc->view_area_mbr.min_y + misc->plan.box[build_index].y_border;
+      actual_mbr.max_y = misc->view_area_mbr.max_y - misc->plan.box[build_index].y_border;
+    }
+
+
+  if ((fp = fopen (ge_tmp_name[1], "w")) == NULL)
+    {
+      emit error (tr ("Unable to open temporary Google Earth KML file!"));
+      return (-1);
+    }
+
+
+  fprintf (fp, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  fprintf (fp, "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n");
+  fprintf (fp, "  <Document>\n");
+
+
+  //  This is the box
+
+  fprintf (fp, "    <Style id=\"Transparent\">\n");
+  fprintf (fp, "      <LineStyle>\n");
+  fprintf (fp, "        <width>1.5</width>\n");
+  fprintf (fp, "      </LineStyle>\n");
+  fprintf (fp, "      <PolyStyle>\n");
+  fprintf (fp, "        <color>00000000</color>\n");
+
+
+  //  The last time through we want to draw the box
+
+  if (build_kill_flag)
+    {
+      fprintf (fp, "        <outline>1</outline>\n");
+    }
+  else
+    {
+      fprintf (fp, "        <outline>0</outline>\n");
+    }
+
+  fprintf (fp, "        <fill>0</fill>\n");
+  fprintf (fp, "      </PolyStyle>\n");
+  fprintf (fp, "    </Style>\n");
+  fprintf (fp, "    <Placemark>\n");
+  fprintf (fp, "      <name>geCache displayed area</name>\n");
+  fprintf (fp, "      <styleUrl>#Transparent</styleUrl>\n");
+  fprintf (fp, "      <Polygon>\n");
+  fprintf (fp, "        <extrude>1</extrude>\n");
+
+
+  //  We also want to tesselate the box on the last time through.
+
+  if (build_kill_flag)
+    {
+      fprintf (fp, "        <tessellate>1</tessellate>\n");
+      fprintf (fp, "        <altitudeMode>clampToGround</altitudeMode>\n");
+    }
+  else
+    {
+      fprintf (fp, "        <altitudeMode>relativeToGround</altitudeMode>\n");
+    }
+
+
+  fprintf (fp, "        <outerBoundaryIs>\n");
+  fprintf (fp, "          <LinearRing>\n");
+  fprintf (fp, "            <coordinates>\n");
+  fprintf (fp, "              %.11f,%.11f,10\n", actual_mbr.min_x, actual_mbr.min_y);
+  fprintf (fp, "              %.11f,%.11f,10\n", actual_mbr.min_x, actual_mbr.max_y);
+  fprintf (fp, "              %.11f,%.11f,10\n", actual_mbr.max_x, actual_mbr.max_y);
+  fprintf (fp, "              %.11f,%.11f,10\n", actual_mbr.max_x, actual_mbr.min_y);
+  fprintf (fp, "              %.11f,%.11f,10\n", actual_mbr.min_x, actual_mbr.min_y);
+  fprintf (fp, "            </coordinates>\n");
+  fprintf (fp, "          </LinearRing>\n");
+  fprintf (fp, "        </outerBoundaryIs>\n");
+  fprintf (fp, "      </Polygon>\n");
+  fprintf (fp, "    </Placemark>\n");
+
+  fprintf (fp, "  </Document>\n");
+  fprintf (fp, "</kml>\n");
+
+  fclose (fp);
+
+
+  //  If we set the kill flag the last time, just return;
+
+  if (build_kill_flag) return (0);
+
+
+  //  Move to the next box in the plan.  If we've passed the last box, we're done.
+
+  build_index++;
+
+  if (build_index >= (int32_t) misc->plan.box.size ()) build_kill_flag = true;
+
+  return (0);
+}
+
+
+
+//!  Error callback from the Google Earth process.
+
+void 
+BuildEngine::slotGoogleEarthError (QProcess::ProcessError error_code)
+{
+  switch (error_code)
+    {
+    case QProcess::FailedToStart:
+      emit error (tr ("Unable to start Google Earth!"));
+      break;
+
+    case QProcess::Crashed:
+      emit error (tr ("Google Earth crashed!"));
+      break;
+
+    case QProcess::Timedout:
+      emit error (tr ("Google Earth timed out!"));
+      break;
+
+    case QProcess::WriteError:
+      emit error (tr ("There was a write error in Google Earth!"));
+      break;
+
+    case QProcess::ReadError:
+      emit error (tr ("There was a read error in Google Earth!"));
+      break;
+
+    case QProcess::UnknownError:
+      emit error (tr ("Google Earth died with an unknown error!"));
+      break;
+    }
+
+
+  if (geProc) stop ();
+}
+
+
+
+void 
+BuildEngine::slotGoogleEarthDone (int exitCode ATTR_UNUSED, QProcess::ExitStatus exitStatus ATTR_UNUSED)
+{
+#ifdef _MSC_VER
+UNREFERENCED_PARAMETER (exitCode);
+UNREFERENCED_PARAMETER (exitStatus);
+#endif
+
+
+  //  It's already dead but stop will clean up all details (as Don Henley would say).
+
+  if (geProc) stop ();
+}
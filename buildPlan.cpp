@@ -0,0 +1,590 @@
+
+/********************************************************************************************* 
+
+    buildPlan.cpp
+
+    Copyright (c) 2016, Jan C. Depner
+
+
+    This file is part of geCache.
+
+    geCache is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    geCache is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with geCache.  If not, see <http://www.gnu.org/licenses/>.
+
+*********************************************************************************************/
+
+
+#include "geCacheEngine.hpp"
+
+
+/*!
+  This function returns the distance along a Hilbert curve that fills an n by n grid (n must be a power of 2) for the cell at x, y.
+  Cells that are close together along the curve are always close together on the grid so visiting the boxes in Hilbert order never
+  makes Google Earth fly more than a few boxes between stops.
+*/
+
+static int64_t hilbertIndex (int32_t n, int32_t x, int32_t y)
+{
+  int64_t d = 0;
+
+  for (int32_t s = n / 2 ; s > 0 ; s /= 2)
+    {
+      int32_t rx = (x & s) > 0;
+      int32_t ry = (y & s) > 0;
+
+      d += (int64_t) s * (int64_t) s * (int64_t) ((3 * rx) ^ ry);
+
+
+      //  Rotate the quadrant so that the sub-curve is oriented properly.
+
+      if (!ry)
+        {
+          if (rx)
+            {
+              x = n - 1 - x;
+              y = n - 1 - y;
+            }
+
+          int32_t tmp = x;
+          x = y;
+          y = tmp;
+        }
+    }
+
+  return (d);
+}
+
+
+
+/*!
+  Each row of the plan has its own box width (in degrees) so the column numbers in different rows don't line up.  For the orders
+  that need to know which boxes are near each other, this function computes a column number for every box on a common grid whose
+  cells are as wide as the narrowest boxes in the plan.  No two boxes in the same row can land in the same column.  Returns the
+  number of columns in the common grid.
+*/
+
+static int32_t gridColumns (BUILD_PLAN *plan, std::vector<int32_t> *gx)
+{
+  double min_dx = *std::min_element (plan->box_size_x_deg.begin (), plan->box_size_x_deg.end ());
+  int32_t cols = 1;
+
+  for (int32_t i = 0 ; i < (int32_t) plan->box.size () ; i++)
+    {
+      double center_x = (plan->box[i].mbr.min_x + plan->box[i].mbr.max_x) * 0.5;
+
+      (*gx)[i] = (int32_t) ((center_x - plan->area_mbr.min_x) / min_dx);
+      cols = qMax (cols, (*gx)[i] + 1);
+    }
+
+  return (cols);
+}
+
+
+
+/*!
+  Reorders the boxes in the plan along a Hilbert curve.  The curve is laid over the smallest power of 2 square that covers the grid.
+  Returns false if we ran out of memory (the plan is unchanged).
+*/
+
+static uint8_t hilbertOrder (BUILD_PLAN *plan)
+{
+  std::vector<std::pair<int64_t, int32_t> > key;
+  std::vector<int32_t> gx;
+
+  try
+    {
+      key.resize (plan->box.size ());
+      gx.resize (plan->box.size ());
+    }
+  catch (std::bad_alloc&)
+    {
+      return (false);
+    }
+
+  int32_t cols = gridColumns (plan, &gx);
+
+  int32_t n = 1;
+  while (n < cols || n < plan->rows) n *= 2;
+
+  for (int32_t i = 0 ; i < (int32_t) plan->box.size () ; i++)
+    {
+      key[i].first = hilbertIndex (n, gx[i], plan->box[i].row);
+      key[i].second = i;
+    }
+
+  std::sort (key.begin (), key.end ());
+
+
+  std::vector<BUILD_BOX> box;
+
+  try
+    {
+      box.resize (plan->box.size ());
+    }
+  catch (std::bad_alloc&)
+    {
+      return (false);
+    }
+
+  for (int32_t i = 0 ; i < (int32_t) key.size () ; i++) box[i] = plan->box[key[i].second];
+
+  plan->box.swap (box);
+
+  return (true);
+}
+
+
+
+/*!
+  Reorders the boxes in the plan so that each box is followed by the closest (in grid cells) box that hasn't been visited yet.  We
+  start with the first box in serpentine order (the SW-most box).  The search for the next box works outward from the current box a
+  ring of grid cells at a time so, in the normal case where the next box is adjacent, it only has to look at 8 cells.  When there is
+  a tie we prefer staying in the same row and then continuing in the same east/west direction we were already moving.  Returns
+  false if we ran out of memory (the plan is unchanged).
+*/
+
+static uint8_t nearestOrder (BUILD_PLAN *plan)
+{
+  int32_t count = (int32_t) plan->box.size ();
+
+  if (count < 3) return (true);
+
+
+  //  Grid of indices (into the serpentine ordered box vector) of the boxes that haven't been visited yet.  -1 means either the box
+  //  isn't in the plan or it has already been visited.
+
+  std::vector<int32_t> cell, gx;
+  std::vector<BUILD_BOX> box;
+  int32_t cols = 0;
+
+  try
+    {
+      gx.resize (count);
+      cols = gridColumns (plan, &gx);
+      cell.assign ((size_t) plan->rows * (size_t) cols, -1);
+      box.reserve (count);
+    }
+  catch (std::bad_alloc&)
+    {
+      return (false);
+    }
+
+  for (int32_t i = 0 ; i < count ; i++) cell[plan->box[i].row * cols + gx[i]] = i;
+
+
+  int32_t current = 0, direction = 1;
+  int32_t max_ring = qMax (plan->rows, cols);
+
+  while (true)
+    {
+      int32_t cur_row = plan->box[current].row;
+      int32_t cur_col = gx[current];
+
+      box.push_back (plan->box[current]);
+      cell[cur_row * cols + cur_col] = -1;
+
+      if ((int32_t) box.size () == count) break;
+
+
+      int32_t best = -1, best_dist = 0, best_dy = 0, best_dx = 0;
+
+      for (int32_t ring = 1 ; ring <= max_ring ; ring++)
+        {
+          //  Every cell in this ring is at least ring cells away so, if we already have one that is closer, we're done.
+
+          if (best >= 0 && ring * ring > best_dist) break;
+
+          int32_t row_start = qMax (0, cur_row - ring);
+          int32_t row_end = qMin (plan->rows - 1, cur_row + ring);
+
+          for (int32_t row = row_start ; row <= row_end ; row++)
+            {
+              int32_t dy = row - cur_row;
+
+
+              //  On the top and bottom rows of the ring we have to check every column, otherwise only the two end columns.
+
+              int32_t step = (abs (dy) == ring) ? 1 : 2 * ring;
+
+              for (int32_t dx = -ring ; dx <= ring ; dx += step)
+                {
+                  int32_t col = cur_col + dx;
+
+                  if (col < 0 || col >= cols) continue;
+
+                  int32_t ndx = cell[row * cols + col];
+
+                  if (ndx < 0) continue;
+
+                  int32_t dist = dx * dx + dy * dy;
+
+                  if (best < 0 || dist < best_dist ||
+                      (dist == best_dist && (abs (dy) < abs (best_dy) ||
+                                             (abs (dy) == abs (best_dy) && dx * direction > best_dx * direction))))
+                    {
+                      best = ndx;
+                      best_dist = dist;
+                      best_dy = dy;
+                      best_dx = dx;
+                    }
+                }
+            }
+        }
+
+      if (best_dx) direction = (best_dx > 0) ? 1 : -1;
+
+      current = best;
+    }
+
+  plan->box.swap (box);
+
+  return (true);
+}
+
+
+
+/*!
+  This function computes the grid of boxes for one level of a cache build.  All of the rows are the same height (box_size meters
+  converted to degrees of latitude at the center of the area) but the width of the boxes (in degrees of longitude) is computed
+  separately for each row at that row's latitude.  There are enough columns in each row and enough rows to completely cover the
+  area (the last column and row may extend past the east and north sides).  Only the grid dimensions are set, no boxes are
+  generated, so this is cheap enough to use for counting the boxes of a rectangle build.  Returns false if we ran out of memory.
+*/
+
+static uint8_t levelGrid (BUILD_PLAN *plan, NV_F64_XYMBR area_mbr, int32_t box_size)
+{
+  double center_x, center_y, row_y, x, y;
+
+
+  plan->area_mbr = area_mbr;
+
+  center_x = area_mbr.min_x + (area_mbr.max_x - area_mbr.min_x) / 2.0;
+  center_y = area_mbr.min_y + (area_mbr.max_y - area_mbr.min_y) / 2.0;
+
+
+  //  Compute the box height in degrees.
+
+  newgp (center_y, center_x, 0.0, box_size, &y, &x);
+  plan->box_size_y_deg = y - center_y;
+
+
+  //  The small fudge factor keeps us from adding a whole row or column when the area is an exact multiple of the box size but the
+  //  division isn't quite exact.
+
+  plan->rows = qMax (1, (int32_t) ceil ((area_mbr.max_y - area_mbr.min_y) / plan->box_size_y_deg - 0.000001));
+
+  try
+    {
+      plan->box_size_x_deg.resize (plan->rows);
+      plan->row_cols.resize (plan->rows);
+    }
+  catch (std::bad_alloc&)
+    {
+      return (false);
+    }
+
+
+  //  Compute the box width in degrees and the number of columns for each row at the latitude of the center of the row (clipped to
+  //  the area so that a last row that hangs over a pole doesn't blow up newgp).
+
+  plan->cols = 0;
+
+  for (int32_t row = 0 ; row < plan->rows ; row++)
+    {
+      row_y = qMin (area_mbr.max_y, area_mbr.min_y + ((double) row + 0.5) * plan->box_size_y_deg);
+
+      newgp (row_y, center_x, 90.0, box_size, &y, &x);
+      plan->box_size_x_deg[row] = x - center_x;
+
+      plan->row_cols[row] = qMax (1, (int32_t) ceil ((area_mbr.max_x - area_mbr.min_x) / plan->box_size_x_deg[row] - 0.000001));
+      plan->cols = qMax (plan->cols, plan->row_cols[row]);
+    }
+
+  return (true);
+}
+
+
+
+/*!
+  This function generates the list of boxes for one level of a cache build.  The boxes are laid out in rows starting at
+  the SW corner of the area on the grid computed by levelGrid.  Since the width of the boxes is computed for each row the boxes
+  are approximately box_size meters wide from the equatorward edge to the poleward edge of a tall area instead of being too wide
+  (leaving gaps) on one side and too narrow (wasting dwell time) on the other.  The borders that are used to shrink the displayed
+  box are also computed for each row.  If polygon is not NULL, only the boxes that overlap the
+  polygon are stored.  The boxes that overlap the polygon are found in a single scanline pass over the polygon edges
+  (polygon_grid_coverage) instead of testing every box in the grid against every polygon edge.  If coverage is not NULL, the boxes
+  that are already covered by the coverage index (at the same or a finer resolution) are dropped.
+
+  The boxes are stored in the order in which they will be visited.  This is either serpentine order (west to east on even rows,
+  east to west on odd rows, moving north one row at a time), Hilbert curve order, or greedy nearest neighbor order.  For polygons
+  with ragged edges the last two keep Google Earth from flying across large parts of the area (and fetching imagery that we aren't
+  going to cache) on its way to the next box.  Returns false if we ran out of memory.
+*/
+
+static uint8_t makeLevel (BUILD_PLAN *plan, NV_F64_XYMBR area_mbr, int32_t box_size, std::vector<NV_F64_COORD2> *polygon, int32_t build_order,
+                       COVERAGE_INDEX *coverage)
+{
+  double center_x, row_y, x, y;
+
+
+  if (!levelGrid (plan, area_mbr, box_size)) return (false);
+  plan->box.clear ();
+
+  center_x = area_mbr.min_x + (area_mbr.max_x - area_mbr.min_x) / 2.0;
+
+
+  //  Compute the sizes of the borders for the box size we're actually going to be moving.  There is always at least 1.25 times the defined box size in 
+  //  the X direction and 1.1 times the box size in the Y direction regardless of aspect ratio in Google Earth.  I'm trying to eliminate some of the
+  //  image redundancy without missing any imagery.  Like the box widths, the borders are computed for each row.
+
+  int32_t x_size = (int32_t) ((float) box_size / 1.25 + 0.5);
+  int32_t y_size = (int32_t) ((float) box_size / 1.1 + 0.5);
+
+  std::vector<double> x_border, y_border;
+
+  try
+    {
+      x_border.resize (plan->rows);
+      y_border.resize (plan->rows);
+    }
+  catch (std::bad_alloc&)
+    {
+      return (false);
+    }
+
+  for (int32_t row = 0 ; row < plan->rows ; row++)
+    {
+      row_y = qMin (area_mbr.max_y, area_mbr.min_y + ((double) row + 0.5) * plan->box_size_y_deg);
+
+      newgp (row_y, center_x, 0.0, y_size, &y, &x);
+      y_border[row] = (plan->box_size_y_deg - (y - row_y)) / 2;
+
+      newgp (row_y, center_x, 90.0, x_size, &y, &x);
+      x_border[row] = (plan->box_size_x_deg[row] - (x - center_x)) / 2;
+    }
+
+
+  std::vector<uint8_t> covered;
+
+  if (polygon)
+    {
+      try
+        {
+          covered.resize ((size_t) plan->rows * (size_t) plan->cols);
+        }
+      catch (std::bad_alloc&)
+        {
+          return (false);
+        }
+
+      if (polygon_grid_coverage (polygon->data (), (int32_t) polygon->size (), area_mbr.min_x, area_mbr.min_y, plan->box_size_x_deg.data (),
+                                 plan->box_size_y_deg, plan->cols, plan->rows, covered.data ())) return (false);
+    }
+
+
+  //  The coverage index grid is built the first time it's needed so get that (and its allocations) out of the way.
+
+  if (coverage && coverage->dirty && !indexCoverage (coverage)) return (false);
+
+
+  for (int32_t row = 0 ; row < plan->rows ; row++)
+    {
+      int32_t row_start = (int32_t) plan->box.size ();
+      int32_t cols = plan->row_cols[row];
+
+      for (int32_t i = 0 ; i < cols ; i++)
+        {
+          BUILD_BOX box;
+
+
+          //  Odd rows go from east to west.
+
+          box.col = (row % 2) ? cols - 1 - i : i;
+          box.row = row;
+          box.level = 0;
+          box.restart = row_start;
+          box.x_border = x_border[row];
+          box.y_border = y_border[row];
+
+          box.mbr.min_x = area_mbr.min_x + (double) box.col * plan->box_size_x_deg[row];
+          box.mbr.max_x = box.mbr.min_x + plan->box_size_x_deg[row];
+          box.mbr.min_y = area_mbr.min_y + (double) row * plan->box_size_y_deg;
+          box.mbr.max_y = box.mbr.min_y + plan->box_size_y_deg;
+
+
+          //  If we're doing a polygon we only want the boxes that overlap it.
+
+          if (polygon && !covered[row * plan->cols + box.col]) continue;
+
+
+          //  If we're doing an incremental build we don't want the boxes that are already in the cache.
+
+          if (coverage && boxCovered (coverage, &box.mbr, box_size)) continue;
+
+          try
+            {
+              plan->box.push_back (box);
+            }
+          catch (std::bad_alloc&)
+            {
+              return (false);
+            }
+        }
+    }
+
+
+  //  In serpentine order we back up to the beginning of the row after the cache has been saved.  The other orders don't have rows
+  //  so we just back up one box to redo the last one that was displayed.
+
+  switch (build_order)
+    {
+    case BUILD_ORDER_HILBERT:
+      if (!hilbertOrder (plan)) return (false);
+      break;
+
+    case BUILD_ORDER_NEAREST:
+      if (!nearestOrder (plan)) return (false);
+      break;
+    }
+
+  if (build_order != BUILD_ORDER_SERPENTINE)
+    {
+      for (int32_t i = 0 ; i < (int32_t) plan->box.size () ; i++) plan->box[i].restart = qMax (0, i - 1);
+    }
+
+  return (true);
+}
+
+
+
+/*!
+  Returns true if the plan was built from exactly these inputs so that makeBuildPlan doesn't have to regenerate it.
+*/
+
+static uint8_t planCurrent (BUILD_PLAN *plan, NV_F64_XYMBR area_mbr, std::vector<int32_t> *box_size, std::vector<NV_F64_COORD2> *polygon,
+                            int32_t build_order, COVERAGE_INDEX *coverage)
+{
+  if (!plan->valid) return (false);
+
+  if (plan->area_mbr.min_x != area_mbr.min_x || plan->area_mbr.max_x != area_mbr.max_x ||
+      plan->area_mbr.min_y != area_mbr.min_y || plan->area_mbr.max_y != area_mbr.max_y) return (false);
+
+  if (plan->level_box_size != *box_size || plan->build_order != build_order) return (false);
+
+  if (plan->coverage_serial != (coverage ? coverage->serial : -1)) return (false);
+
+  uint32_t count = polygon ? (uint32_t) polygon->size () : 0;
+
+  if (plan->polygon.size () != count) return (false);
+
+  for (uint32_t i = 0 ; i < count ; i++)
+    {
+      if (plan->polygon[i].x != polygon->at (i).x || plan->polygon[i].y != polygon->at (i).y) return (false);
+    }
+
+  return (true);
+}
+
+
+
+/*!
+  This function generates the list of boxes that will be displayed during a cache build.  box_size is the list of box sizes (in
+  meters) for each level of the build, coarsest first.  A normal build only has one level.  For a pyramid build each level is a
+  complete pass over the area (see makeLevel) and the levels are visited from coarse to fine so that the low resolution overview
+  imagery gets cached cheaply before we spend the long dwell time on the detailed imagery.  The rows, cols, box_size_x_deg,
+  box_size_y_deg, and row_cols fields of the plan describe the grid of the finest level.  If the plan was already built from the
+  same inputs it is left alone.  Returns false (with an empty, invalid plan) if we ran out of memory.
+*/
+
+uint8_t makeBuildPlan (BUILD_PLAN *plan, NV_F64_XYMBR area_mbr, std::vector<int32_t> *box_size, std::vector<NV_F64_COORD2> *polygon, int32_t build_order,
+                       COVERAGE_INDEX *coverage)
+{
+  BUILD_PLAN level;
+
+
+  if (planCurrent (plan, area_mbr, box_size, polygon, build_order, coverage)) return (true);
+
+
+  plan->box.clear ();
+  plan->valid = false;
+  plan->level_box_size = *box_size;
+
+  for (int32_t i = 0 ; i < (int32_t) box_size->size () ; i++)
+    {
+      if (!makeLevel (&level, area_mbr, box_size->at (i), polygon, build_order, coverage))
+        {
+          plan->box.clear ();
+          return (false);
+        }
+
+
+      //  The restart indices are relative to the start of the level so we have to offset them.
+
+      int32_t offset = (int32_t) plan->box.size ();
+
+      for (int32_t j = 0 ; j < (int32_t) level.box.size () ; j++)
+        {
+          level.box[j].level = i;
+          level.box[j].restart += offset;
+        }
+
+      try
+        {
+          plan->box.insert (plan->box.end (), level.box.begin (), level.box.end ());
+        }
+      catch (std::bad_alloc&)
+        {
+          plan->box.clear ();
+          return (false);
+        }
+    }
+
+  plan->area_mbr = area_mbr;
+  plan->rows = level.rows;
+  plan->cols = level.cols;
+  plan->box_size_y_deg = level.box_size_y_deg;
+  plan->box_size_x_deg.swap (level.box_size_x_deg);
+  plan->row_cols.swap (level.row_cols);
+
+  plan->polygon.clear ();
+  if (polygon) plan->polygon = *polygon;
+  plan->build_order = build_order;
+  plan->coverage_serial = coverage ? coverage->serial : -1;
+  plan->valid = true;
+
+  return (true);
+}
+
+
+
+/*!
+  This function returns the number of boxes in a rectangle build of area_mbr (without an incremental coverage index) without
+  generating the plan.  Every box in the grid of a level is visited so the count is just the sum of the number of columns in each
+  row of each level.  Returns -1 if we ran out of memory.
+*/
+
+int32_t countBuildPlan (NV_F64_XYMBR area_mbr, std::vector<int32_t> *box_size)
+{
+  BUILD_PLAN level;
+  int32_t count = 0;
+
+
+  for (int32_t i = 0 ; i < (int32_t) box_size->size () ; i++)
+    {
+      if (!levelGrid (&level, area_mbr, box_size->at (i))) return (-1);
+
+      for (int32_t row = 0 ; row < level.rows ; row++) count += level.row_cols[row];
+    }
+
+  return (count);
+}
@@ -0,0 +1,377 @@
+
+/********************************************************************************************* 
+
+    cacheSize.cpp
+
+    Copyright (c) 2016, Jan C. Depner
+
+
+    This file is part of geCache.
+
+    geCache is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    geCache is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with geCache.  If not, see <http://www.gnu.org/licenses/>.
+
+*********************************************************************************************/
+
+
+
+#include "geCacheEngine.hpp"
+
+
+/*!
+  These functions keep track of the size of the Google Earth cache directory during a cache build.  Instead of walking the whole
+  cache every time the build timer wants the size (which stats every file in the cache on the GUI thread), we take one full scan
+  when the build starts and keep the size of every file.  After that we only stat the files that the cache watcher says have
+  changed (see BuildEngine::slotCacheActivity).  When a directory changes we just read the names in it (listDir) to find the files
+  that have been added or removed.  Google Earth keeps almost all of its leveldb files in one directory so re-stat'ing the whole
+  directory would be nearly as bad as walking the cache.  New files are stat'ed each time the size is asked for until they stop
+  growing since we don't watch them.  Writes to other files we don't watch can be missed so we do a full scan every
+  CACHE_SIZE_RESCAN milliseconds to pull the total back in line.  The full scans are done by sizeDirs (sizeDir.cpp).  The periodic
+  ones, and the first one after resetCacheSize, are run in the background (DirSizer) and handed to rescanCacheSize when they
+  finish.  Until the first one is in (see CACHE_SIZE.sized) the build waits and the changes just pile up in the dirty sets.
+*/
+
+#define CACHE_SIZE_RESCAN  300000
+
+
+//  Total size of the files in one directory.
+
+static int64_t filesSize (const QHash<QString, int64_t> &files)
+{
+  int64_t size = 0;
+
+  for (QHash<QString, int64_t>::const_iterator it = files.constBegin () ; it != files.constEnd () ; ++it) size += it.value ();
+
+  return (size);
+}
+
+
+
+//  Compute the size of a new directory and everything under it.
+
+static void sizeTree (CACHE_SIZE *cache_size, const QString &path)
+{
+  DIR_FILES dir_files;
+
+  sizeDirs (path, &dir_files);
+
+  for (DIR_FILES::const_iterator it = dir_files.constBegin () ; it != dir_files.constEnd () ; ++it)
+    {
+      cache_size->total += filesSize (it.value ()) - filesSize (cache_size->dir_files.value (it.key ()));
+      cache_size->dir_files.insert (it.key (), it.value ());
+    }
+}
+
+
+
+//  Forget about a directory (and everything under it) that has been removed.
+
+static void removeTree (CACHE_SIZE *cache_size, const QString &path)
+{
+  QString prefix = path + "/";
+
+  DIR_FILES::iterator it = cache_size->dir_files.begin ();
+
+  while (it != cache_size->dir_files.end ())
+    {
+      if (it.key () == path || it.key ().startsWith (prefix))
+        {
+          cache_size->total -= filesSize (it.value ());
+          it = cache_size->dir_files.erase (it);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+}
+
+
+
+//  Stat one file that has changed (or been added or removed).  Returns true if its size changed.
+
+static uint8_t refreshFile (CACHE_SIZE *cache_size, const QString &path)
+{
+  QFileInfo info (path);
+
+  DIR_FILES::iterator dir = cache_size->dir_files.find (info.absolutePath ());
+
+
+  //  If we don't know about the directory it's new and it will be sized when its parent directory change shows up.
+
+  if (dir == cache_size->dir_files.end ()) return (false);
+
+  QString name = info.fileName ();
+  int64_t old_size = dir.value ().value (name, -1);
+
+  if (info.exists () && !info.isDir () && !info.isSymLink ())
+    {
+      int64_t size = info.size ();
+
+      if (size == old_size) return (false);
+
+      cache_size->total += size - qMax ((int64_t) 0, old_size);
+      dir.value ().insert (name, size);
+
+      return (true);
+    }
+
+  if (old_size < 0) return (false);
+
+  cache_size->total -= old_size;
+  dir.value ().remove (name);
+
+  return (true);
+}
+
+
+
+//  A directory has changed.  Files that have been added are stat'ed (and followed until they stop growing), files that are gone
+//  are dropped, new subdirectories are sized completely, and subdirectories that have gone away are dropped.  The files that are
+//  still there aren't stat'ed.
+
+static void refreshDir (CACHE_SIZE *cache_size, const QString &path)
+{
+  if (!QFileInfo (path).isDir ())
+    {
+      removeTree (cache_size, path);
+      return;
+    }
+
+  if (!cache_size->dir_files.contains (path))
+    {
+      sizeTree (cache_size, path);
+      return;
+    }
+
+
+  QStringList files, subdirs;
+
+  listDir (path, &files, &subdirs);
+
+
+  QHash<QString, int64_t> *known = &cache_size->dir_files[path];
+
+  QSet<QString> present;
+
+  for (int32_t i = 0 ; i < files.size () ; i++)
+    {
+      present.insert (files.at (i));
+
+      if (!known->contains (files.at (i)))
+        {
+          QString file = path + "/" + files.at (i);
+
+          known->insert (files.at (i), 0);
+          refreshFile (cache_size, file);
+          cache_size->growing.insert (file);
+        }
+    }
+
+  QHash<QString, int64_t>::iterator it = known->begin ();
+
+  while (it != known->end ())
+    {
+      if (!present.contains (it.key ()))
+        {
+          cache_size->total -= it.value ();
+          it = known->erase (it);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+
+
+  for (int32_t i = 0 ; i < subdirs.size () ; i++)
+    {
+      if (!cache_size->dir_files.contains (subdirs.at (i))) sizeTree (cache_size, subdirs.at (i));
+    }
+
+  QStringList gone;
+
+  for (DIR_FILES::const_iterator it = cache_size->dir_files.constBegin () ; it != cache_size->dir_files.constEnd () ; ++it)
+    {
+      if (it.key () != path && QFileInfo (it.key ()).absolutePath () == path && !subdirs.contains (it.key ())) gone += it.key ();
+    }
+
+  for (int32_t i = 0 ; i < gone.size () ; i++) removeTree (cache_size, gone.at (i));
+}
+
+
+
+//  Add up the sizes of all of the files.
+
+static void totalCacheSize (CACHE_SIZE *cache_size)
+{
+  cache_size->total = 0;
+
+  for (DIR_FILES::const_iterator it = cache_size->dir_files.constBegin () ; it != cache_size->dir_files.constEnd () ; ++it)
+    cache_size->total += filesSize (it.value ());
+}
+
+
+
+//  Start tracking cache_dir.  The caller has to start a full scan in the background (see BuildEngine::startCacheScan) and hand
+//  it to rescanCacheSize.  Any scan that was started before this is thrown away when it finishes.
+
+void resetCacheSize (CACHE_SIZE *cache_size, const QString &cache_dir)
+{
+  cache_size->cache_dir = QDir::cleanPath (QDir (cache_dir).absolutePath ());
+  cache_size->dir_files.clear ();
+  cache_size->dirty_dirs.clear ();
+  cache_size->dirty_files.clear ();
+  cache_size->growing.clear ();
+  cache_size->box_history.clear ();
+  cache_size->total = 0;
+  cache_size->sized = false;
+  cache_size->scan_timestamp = QDateTime::currentMSecsSinceEpoch ();
+}
+
+
+
+//  Returns true if it's time for a full scan of the cache directory.
+
+uint8_t cacheSizeRescanDue (CACHE_SIZE *cache_size)
+{
+  if (cache_size->cache_dir.isEmpty ()) return (false);
+
+  return (QDateTime::currentMSecsSinceEpoch () - cache_size->scan_timestamp > CACHE_SIZE_RESCAN);
+}
+
+
+
+//  Replace the file sizes with the results of a full scan that was started at timestamp.  If the tracker has been reset since the
+//  scan started (the cache was restored from the snapshot) the results are no good.  Any files or directories that changed while
+//  the scan was running are still in the dirty sets so they'll be looked at again the next time cacheSize is called.
+
+void rescanCacheSize (CACHE_SIZE *cache_size, DIR_FILES *dir_files, int64_t timestamp)
+{
+  if (timestamp < cache_size->scan_timestamp) return;
+
+  cache_size->dir_files.swap (*dir_files);
+  cache_size->scan_timestamp = timestamp;
+  cache_size->sized = true;
+
+  totalCacheSize (cache_size);
+}
+
+
+
+//  The cache watcher says that path (a directory or a file) has changed.  We just remember what needs to be looked at again, the
+//  work is done the next time somebody asks for the size.
+
+void cacheSizeChanged (CACHE_SIZE *cache_size, const QString &path)
+{
+  QString clean = QDir::cleanPath (QDir (path).absolutePath ());
+
+
+  //  Until the first scan is in we don't know the directories so we have to look.
+
+  if (cache_size->dir_files.contains (clean) || (!cache_size->sized && QFileInfo (clean).isDir ()))
+    {
+      cache_size->dirty_dirs.insert (clean);
+    }
+  else
+    {
+      cache_size->dirty_files.insert (clean);
+    }
+}
+
+
+
+//  Returns true if path is the cache directory or is inside it.
+
+static uint8_t inCache (CACHE_SIZE *cache_size, const QString &path)
+{
+  return (path == cache_size->cache_dir || path.startsWith (cache_size->cache_dir + "/"));
+}
+
+
+
+//  Returns the current size of the cache directory.
+
+int64_t cacheSize (CACHE_SIZE *cache_size)
+{
+  if (cache_size->cache_dir.isEmpty () || !cache_size->sized) return (cache_size->total);
+
+
+  //  Keep checking the files that were new last time until their size stops changing (before we add this time's new files).
+
+  QSet<QString>::iterator it = cache_size->growing.begin ();
+
+  while (it != cache_size->growing.end ())
+    {
+      if (refreshFile (cache_size, *it))
+        {
+          ++it;
+        }
+      else
+        {
+          it = cache_size->growing.erase (it);
+        }
+    }
+
+
+  for (it = cache_size->dirty_dirs.begin () ; it != cache_size->dirty_dirs.end () ; ++it)
+    {
+      if (inCache (cache_size, *it)) refreshDir (cache_size, *it);
+    }
+
+  cache_size->dirty_dirs.clear ();
+
+  for (it = cache_size->dirty_files.begin () ; it != cache_size->dirty_files.end () ; ++it)
+    {
+      if (inCache (cache_size, *it)) refreshFile (cache_size, *it);
+    }
+
+  cache_size->dirty_files.clear ();
+
+  return (cache_size->total);
+}
+
+
+
+//  Remember the size of the cache after a box has been displayed.  We only keep the last CACHE_GROWTH_BOXES sizes.
+
+void addCacheSizeHistory (CACHE_SIZE *cache_size, int64_t size)
+{
+  cache_size->box_history.push_back (size);
+
+  if ((int32_t) cache_size->box_history.size () > CACHE_GROWTH_BOXES + 1) cache_size->box_history.erase (cache_size->box_history.begin ());
+}
+
+
+
+/*!
+  Returns the size that we expect the cache to be after the next box has been displayed.  This is the last size plus the average
+  growth per box over the last CACHE_GROWTH_BOXES boxes or the growth of the last box, whichever is larger (a dense area usually
+  sits next to other dense areas).  That way we can save the cache before a box pushes it past the limit instead of after.
+*/
+
+int64_t projectCacheSize (CACHE_SIZE *cache_size)
+{
+  int32_t count = (int32_t) cache_size->box_history.size ();
+
+  if (!count) return (0);
+
+  int64_t last = cache_size->box_history[count - 1];
+
+  if (count < 2) return (last);
+
+  int64_t average = (last - cache_size->box_history[0]) / (count - 1);
+  int64_t recent = last - cache_size->box_history[count - 2];
+
+  return (last + qMax ((int64_t) 0, qMax (average, recent)));
+}
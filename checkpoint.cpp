@@ -0,0 +1,199 @@
+
+/********************************************************************************************* 
+
+    checkpoint.cpp
+
+    Copyright (c) 2016, Jan C. Depner
+
+
+    This file is part of geCache.
+
+    geCache is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    geCache is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with geCache.  If not, see <http://www.gnu.org/licenses/>.
+
+*********************************************************************************************/
+
+
+
+#include "geCacheEngine.hpp"
+
+
+/*!
+  These functions save and restore the state of a running cache build so that it can be resumed if Google Earth crashes or the
+  machine goes down in the middle of a long build.  The checkpoint is a small .ini file (geCache_checkpoint.ini) that is stored
+  in the same place as geCache.ini.  It contains everything needed to regenerate the build plan (the area, the polygon, the box
+  size, the build order, the pyramid levels, and whether it's an incremental build) along with the index of the next box to be
+  visited, the index of the first box that is in the current cache (see coverage.cpp), and the location of the cache snapshot.  For
+  an unattended build it also has the segment base name and the number of the next segment.  It is rewritten after every box and
+  removed when the build finishes.  Command line (batch and queue) builds write geCache_batch_checkpoint.ini instead so that they
+  never overwrite (or remove) the resume point of an interrupted build that was started from the GUI.
+*/
+
+QString checkpointName (uint8_t batch_run)
+{
+  QString name = batch_run ? "/geCache_batch_checkpoint.ini" : "/geCache_checkpoint.ini";
+
+#ifdef _MSC_VER
+  return (QString (getenv ("USERPROFILE")) + name);
+#else
+  return (QString (getenv ("HOME")) + name);
+#endif
+}
+
+
+
+//  Returns the Google Earth cache directory that the checkpoint was written for (empty if there is no checkpoint).
+
+QString checkpointCacheDir (uint8_t batch_run)
+{
+  if (!QFileInfo (checkpointName (batch_run)).exists ()) return (QString ());
+
+  QSettings settings (checkpointName (batch_run), QSettings::IniFormat);
+
+  return (settings.value (QString ("checkpoint/google earth cache directory"), QString ("")).toString ());
+}
+
+
+
+void writeCheckpoint (OPTIONS *options, MISC *misc, int32_t build_index, int32_t coverage_start, QString cache_snapshot)
+{
+  QSettings settings (checkpointName (misc->batch_run), QSettings::IniFormat);
+  settings.beginGroup ("checkpoint");
+
+
+  settings.setValue (QString ("version"), QString (misc->version));
+
+  settings.setValue (QString ("google earth cache directory"), options->ge_dir);
+  settings.setValue (QString ("cache snapshot"), cache_snapshot);
+
+  settings.setValue (QString ("shape tab"), options->shape_tab);
+
+  settings.setValue (QString ("cache south boundary latitude"), options->cache_mbr.min_y);
+  settings.setValue (QString ("cache north boundary latitude"), options->cache_mbr.max_y);
+  settings.setValue (QString ("cache west boundary longitude"), options->cache_mbr.min_x);
+  settings.setValue (QString ("cache east boundary longitude"), options->cache_mbr.max_x);
+
+  settings.beginWriteArray ("Polygon points");
+
+  for (uint32_t i = 0 ; i < options->polygon.size () ; i++)
+    {
+      settings.setArrayIndex (i);
+      settings.setValue ("lat", options->polygon.at (i).y);
+      settings.setValue ("lon", options->polygon.at (i).x);
+    }
+  settings.endArray ();
+
+  settings.setValue (QString ("build box size"), options->build_box_size);
+  settings.setValue (QString ("build order"), options->build_order);
+  settings.setValue (QString ("incremental build"), options->incremental_build);
+  settings.setValue (QString ("unattended build"), options->unattended_build);
+  settings.setValue (QString ("segment base"), misc->segment_base);
+  settings.setValue (QString ("segment number"), misc->segment_number);
+
+  QStringList levels;
+  for (uint32_t i = 0 ; i < options->pyramid_levels.size () ; i++) levels += QString::number (options->pyramid_levels.at (i));
+  settings.setValue (QString ("pyramid levels"), levels.join (","));
+
+
+  //  The number of boxes in the plan is used to make sure that the plan we regenerate when we resume is the same one we were
+  //  working on.
+
+  settings.setValue (QString ("box count"), (int32_t) misc->plan.box.size ());
+  settings.setValue (QString ("build index"), build_index);
+  settings.setValue (QString ("coverage start"), coverage_start);
+
+  settings.endGroup ();
+
+
+  //  Make sure it actually gets written to disk now (that's the whole point).
+
+  settings.sync ();
+}
+
+
+
+/*!
+  Reads the checkpoint file (if there is one) and puts the area definition and build parameters into options.  Returns false
+  if there is no checkpoint, it was written for a different Google Earth cache directory, or we ran out of memory.
+*/
+
+uint8_t readCheckpoint (OPTIONS *options, MISC *misc, int32_t *build_index, int32_t *box_count, int32_t *coverage_start, QString *cache_snapshot)
+{
+  if (!QFileInfo (checkpointName (misc->batch_run)).exists ()) return (false);
+
+
+  QSettings settings (checkpointName (misc->batch_run), QSettings::IniFormat);
+  settings.beginGroup ("checkpoint");
+
+
+  if (settings.value (QString ("google earth cache directory"), QString ("")).toString () != options->ge_dir) return (false);
+
+  *cache_snapshot = settings.value (QString ("cache snapshot"), QString ("")).toString ();
+
+  options->shape_tab = settings.value (QString ("shape tab"), options->shape_tab).toInt ();
+
+  options->cache_mbr.min_y = settings.value (QString ("cache south boundary latitude"), options->cache_mbr.min_y).toDouble ();
+  options->cache_mbr.max_y = settings.value (QString ("cache north boundary latitude"), options->cache_mbr.max_y).toDouble ();
+  options->cache_mbr.min_x = settings.value (QString ("cache west boundary longitude"), options->cache_mbr.min_x).toDouble ();
+  options->cache_mbr.max_x = settings.value (QString ("cache east boundary longitude"), options->cache_mbr.max_x).toDouble ();
+
+  int32_t size = settings.beginReadArray ("Polygon points");
+
+  try
+    {
+      options->polygon.resize (size);
+    }
+  catch (std::bad_alloc&)
+    {
+      options->polygon.clear ();
+      settings.endArray ();
+      settings.endGroup ();
+      return (false);
+    }
+
+  for (int32_t i = 0 ; i < size ; i++)
+    {
+      settings.setArrayIndex (i);
+
+      options->polygon[i].y = settings.value ("lat").toDouble ();
+      options->polygon[i].x = settings.value ("lon").toDouble ();
+    }
+
+  settings.endArray ();
+
+  options->build_box_size = settings.value (QString ("build box size"), options->build_box_size).toInt ();
+  options->build_order = settings.value (QString ("build order"), options->build_order).toInt ();
+  options->incremental_build = settings.value (QString ("incremental build"), false).toBool ();
+  options->unattended_build = settings.value (QString ("unattended build"), false).toBool ();
+  misc->segment_base = settings.value (QString ("segment base"), QString ("")).toString ();
+  misc->segment_number = settings.value (QString ("segment number"), 1).toInt ();
+
+  QStringList levels = settings.value (QString ("pyramid levels"), QString ("")).toString ().split (",", QString::SkipEmptyParts);
+  options->pyramid_levels.clear ();
+  for (int32_t i = 0 ; i < levels.size () ; i++) options->pyramid_levels.push_back (levels.at (i).toInt ());
+
+  *box_count = settings.value (QString ("box count"), 0).toInt ();
+  *build_index = settings.value (QString ("build index"), 0).toInt ();
+  *coverage_start = settings.value (QString ("coverage start"), 0).toInt ();
+
+  settings.endGroup ();
+
+  return (true);
+}
+
+
+
+void removeCheckpoint (MISC *misc)
+{
+  QFile (checkpointName (misc->batch_run)).remove ();
+}
@@ -24,157 +24,90 @@
 *********************************************************************************************/
 
 
-#include "geCache.hpp"
+#include "geCacheEngine.hpp"
 
-void computeSize (MISC *misc, OPTIONS *options)
-{
-  double mheight, mwidth, center_x, center_y, az, x, y;
-
-
-  //  Set the default flag for positionBuildGoogleEarth.
-
-  misc->view_flag = true;
-  misc->poly_flag = false;
-
-
-  /******************************************************** Rectangle ********************************************************************/
-
-  //  We always compute the information for a rectangle build...
-
-  invgp (NV_A0, NV_B0, options->cache_mbr.min_y, options->cache_mbr.min_x, options->cache_mbr.max_y, options->cache_mbr.min_x, &mheight, &az);
-
-  center_x = options->cache_mbr.min_x + (options->cache_mbr.max_x - options->cache_mbr.min_x) / 2.0;
-  center_y = options->cache_mbr.min_y + (options->cache_mbr.max_y - options->cache_mbr.min_y) / 2.0;
-
-  invgp (NV_A0, NV_B0, center_y, options->cache_mbr.min_x, center_y, options->cache_mbr.max_x, &mwidth, &az);
-
-  QString mtr;
-  mtr.sprintf ("Width = %.1f meters", mwidth);
-  misc->meterWidth->setText (mtr);
-  mtr.sprintf ("Height = %.1f meters", mheight);
-  misc->meterHeight->setText (mtr);
 
-  misc->build_area_mbr = options->cache_mbr;
-
-
-  //  Compute the box size in degrees.
-
-  newgp (center_y, center_x, 0.0, options->build_box_size, &y, &x);
-  misc->box_size_y_deg = y - center_y;
-
-  newgp (center_y, center_x, 90.0, options->build_box_size, &y, &x);
-  misc->box_size_x_deg = x - center_x;
-
-
-  //  Compute the sizes of the borders for the box size we're actually going to be moving.  There is always at least 1.25 times the defined box size in 
-  //  the X direction and 1.1 times the box size in the Y direction regardless of aspect ratio in Google Earth.  I'm trying to eliminate some of the
-  //  image redundancy without missing any imagery.
-
-  int32_t x_size = (int32_t) ((float) options->build_box_size / 1.25 + 0.5);
-  int32_t y_size = (int32_t) ((float) options->build_box_size / 1.1 + 0.5);
 
-  newgp (center_y, center_x, 0.0, y_size, &y, &x);
-  misc->y_border = (misc->box_size_y_deg - (y - center_y)) / 2;
+/*!
+  Sets up the list of box sizes for each level of the build (coarsest first).  For a pyramid build this is any of the pyramid
+  levels that are larger than the build box size followed by the build box size.  Otherwise it's just the build box size.
+*/
 
-  newgp (center_y, center_x, 90.0, x_size, &y, &x);
-  misc->x_border = (misc->box_size_x_deg - (x - center_x)) / 2;
-
-
-  //  Make the initial small area MBR for the build process.
-
-  misc->view_area_mbr.min_y = misc->build_area_mbr.min_y;
-  misc->view_area_mbr.min_x = misc->build_area_mbr.min_x;
-  misc->view_area_mbr.max_y = misc->view_area_mbr.min_y + misc->box_size_y_deg;
-  misc->view_area_mbr.max_x = misc->view_area_mbr.min_x + misc->box_size_x_deg;
-
-
-  //  Figure out how many iterations it will take to do the build so that we can set up a progress bar.
-
-  misc->iterations = 1;
-  uint8_t done = false, direction = 0;
-  NV_F64_XYMBR test_mbr = misc->view_area_mbr;
-
-  do
-     {
-      switch (direction)
-        {
-        case 0:
-
-          //  Move right one box
-
-          test_mbr.min_x += misc->box_size_x_deg;
-
-
-          //  If we've passed the end of the area...
-
-          if (test_mbr.max_x >= misc->build_area_mbr.max_x)
-            {
-              //  Reset min_x to the previous location.
-
-              test_mbr.min_x -= misc->box_size_x_deg;
+static void levelBoxSizes (OPTIONS *options, std::vector<int32_t> *box_size)
+{
+  box_size->clear ();
 
+  for (uint32_t i = 0 ; i < options->pyramid_levels.size () ; i++)
+    {
+      if (options->pyramid_levels[i] > options->build_box_size) box_size->push_back (options->pyramid_levels[i]);
+    }
 
-              //  Move up one box
+  std::sort (box_size->begin (), box_size->end (), std::greater<int32_t> ());
+  box_size->erase (std::unique (box_size->begin (), box_size->end ()), box_size->end ());
+  box_size->push_back (options->build_box_size);
+}
 
-              test_mbr.min_y += misc->box_size_y_deg;
 
 
-              //  If we've passed the top of the area, finish.
+/*!
+  Computes the size of the build area, the number of boxes, and the estimated build time for the rectangle and (if we're on the
+  polygon tab) the polygon.  This is called every time the bounds, the box size, or the polygon changes so the rectangle count is
+  computed directly from the grid dimensions (countBuildPlan).  The polygon count (and the rectangle count for an incremental
+  build) needs the actual list of boxes so it comes from misc->plan, which makeBuildPlan only regenerates when its inputs change.
+  The results are left in misc (area_width, area_height, iterations, total_rect_time, poly_iterations, and total_poly_time) for
+  the caller to display.  Returns false if the plan couldn't be made (we ran out of memory).
+*/
 
-              if (test_mbr.min_y >= misc->build_area_mbr.max_y)
-                {
-                  done = true;
-                }
-              else
-                {
-                  direction = 1;
-                }
-            }
+uint8_t computeSize (MISC *misc, OPTIONS *options)
+{
+  double center_x, center_y, az;
 
-          break;
 
-        case 1:
+  //  Set the default flag for BuildEngine::positionGoogleEarth.
 
-          //  Move left one box
+  misc->poly_flag = false;
 
-          test_mbr.min_x -= misc->box_size_x_deg;
 
+  /******************************************************** Rectangle ********************************************************************/
 
-          //  If we've passed the end of the area...
+  //  We always compute the information for a rectangle build...
 
-          if (test_mbr.max_x <= misc->build_area_mbr.min_x)
-            {
-              //  Reset min_x to the previous location.
+  invgp (NV_A0, NV_B0, options->cache_mbr.min_y, options->cache_mbr.min_x, options->cache_mbr.max_y, options->cache_mbr.min_x, &misc->area_height, &az);
 
-              test_mbr.min_x += misc->box_size_x_deg;
+  center_x = options->cache_mbr.min_x + (options->cache_mbr.max_x - options->cache_mbr.min_x) / 2.0;
+  center_y = options->cache_mbr.min_y + (options->cache_mbr.max_y - options->cache_mbr.min_y) / 2.0;
 
+  invgp (NV_A0, NV_B0, center_y, options->cache_mbr.min_x, center_y, options->cache_mbr.max_x, &misc->area_width, &az);
 
-              //  Move up one box
+  misc->build_area_mbr = options->cache_mbr;
 
-              test_mbr.min_y += misc->box_size_y_deg;
 
+  std::vector<int32_t> box_size;
+  levelBoxSizes (options, &box_size);
 
-              //  If we've passed the top of the area, finish.
 
-              if (test_mbr.min_y >= misc->build_area_mbr.max_y)
-                {
-                  done = true;
-                }
-              else
-                {
-                  direction = 0;
-                }
-            }
+  //  Count the boxes so that we know how many iterations it will take to do the build (this is also used to set up the progress
+  //  bar).  The extra iteration is for the final view of the entire area.  For an incremental build we only want the boxes that
+  //  aren't already in the cache so we have to generate the plan to find out which ones those are.  We don't do that when we're
+  //  doing a polygon build though.  The polygon plan goes in misc->plan too and making both would rebuild both of them (and look
+  //  up every box in the coverage index) every time this is called.
 
-          break;
-        }
+  uint8_t poly_build = (options->shape_tab == POLY_TAB && options->polygon.size ());
 
-      test_mbr.max_y = test_mbr.min_y + misc->box_size_y_deg;
-      test_mbr.max_x = test_mbr.min_x + misc->box_size_x_deg;
+  int32_t box_count;
 
-      misc->iterations++;
+  if (options->incremental_build && !poly_build)
+    {
+      if (!makeBuildPlan (&misc->plan, misc->build_area_mbr, &box_size, NULL, options->build_order, &misc->coverage)) return (false);
+      box_count = (int32_t) misc->plan.box.size ();
+    }
+  else
+    {
+      box_count = countBuildPlan (misc->build_area_mbr, &box_size);
+      if (box_count < 0) return (false);
+    }
 
-    } while (!done);
+  misc->iterations = box_count + 1;
 
 
   //  Compute a rough estimate of how long this will take.
@@ -182,19 +115,11 @@ void computeSize (MISC *misc, OPTIONS *options)
   misc->total_rect_time = misc->iterations * options->cache_update_frequency + 20;
 
 
-  int32_t hour = misc->total_rect_time / 3600;
-  int32_t minute = (misc->total_rect_time / 60) % 60;
-  int32_t second = misc->total_rect_time % 60;
-
-  misc->rectEstTime->setText (geCache::tr ("Estimated time to build = %1:%2:%3").arg (hour, 2, 10, zero).arg (minute, 2, 10, zero).arg (second, 2, 10, zero));
-
-
-
   /******************************************************** Polygon *********************************************************************/
 
   //  Check to see if we're doing a polygon build (if we're on the polygon tab and we have polygon points).
 
-  if (options->shape_tab == POLY_TAB && options->polygon.size ())
+  if (poly_build)
     {
       misc->poly_flag = true;
 
@@ -214,216 +139,43 @@ void computeSize (MISC *misc, OPTIONS *options)
           misc->build_area_mbr.max_y = qMax (options->polygon[i].y, misc->build_area_mbr.max_y);
         }
 
-      invgp (NV_A0, NV_B0, misc->build_area_mbr.min_y, misc->build_area_mbr.min_x, misc->build_area_mbr.max_y, misc->build_area_mbr.min_x, &mheight, &az);
-
-      center_x = misc->build_area_mbr.min_x + (misc->build_area_mbr.max_x - misc->build_area_mbr.min_x) / 2.0;
-      center_y = misc->build_area_mbr.min_y + (misc->build_area_mbr.max_y - misc->build_area_mbr.min_y) / 2.0;
-
-      invgp (NV_A0, NV_B0, center_y, misc->build_area_mbr.min_x, center_y, misc->build_area_mbr.max_x, &mwidth, &az);
-
-
-      //  Compute the box size in degrees.
-
-      newgp (center_y, center_x, 0.0, options->build_box_size, &y, &x);
-      misc->box_size_y_deg = y - center_y;
+      //  The polygon build plan only contains the boxes that overlap the polygon.
 
-      newgp (center_y, center_x, 90.0, options->build_box_size, &y, &x);
-      misc->box_size_x_deg = x - center_x;
+      COVERAGE_INDEX *coverage = NULL;
+      if (options->incremental_build) coverage = &misc->coverage;
 
+      if (!makeBuildPlan (&misc->plan, misc->build_area_mbr, &box_size, &options->polygon, options->build_order, coverage)) return (false);
 
-      //  Compute the sizes of the borders for the box size we're actually going to be moving.  There is always at least 1.25 times the defined box size in 
-      //  the X direction and 1.1 times the box size in the Y direction regardless of aspect ratio in Google Earth.  I'm trying to eliminate some of the
-      //  image redundancy without missing any imagery.
+      misc->poly_iterations = (int32_t) misc->plan.box.size () + 1;
 
-      int32_t x_size = (int32_t) ((float) options->build_box_size / 1.25 + 0.5);
-      int32_t y_size = (int32_t) ((float) options->build_box_size / 1.1 + 0.5);
 
-      newgp (center_y, center_x, 0.0, y_size, &y, &x);
-      misc->y_border = (misc->box_size_y_deg - (y - center_y)) / 2;
-
-      newgp (center_y, center_x, 90.0, x_size, &y, &x);
-      misc->x_border = (misc->box_size_x_deg - (x - center_x)) / 2;
-
-
-      //  Make the initial small area MBR for the build process.
-
-      misc->view_area_mbr.min_y = misc->build_area_mbr.min_y;
-      misc->view_area_mbr.min_x = misc->build_area_mbr.min_x;
-      misc->view_area_mbr.max_y = misc->view_area_mbr.min_y + misc->box_size_y_deg;
-      misc->view_area_mbr.max_x = misc->view_area_mbr.min_x + misc->box_size_x_deg;
-
-
-      //  We need to set misc->view_flag to false if the first box is completely out of the polygon.
-
-      NV_F64_COORD2 mbr_poly[4];
-
-      mbr_poly[0].x = misc->view_area_mbr.min_x;
-      mbr_poly[0].y = misc->view_area_mbr.min_y;
-      mbr_poly[1].x = misc->view_area_mbr.min_x;
-      mbr_poly[1].y = misc->view_area_mbr.max_y;
-      mbr_poly[2].x = misc->view_area_mbr.max_x;
-      mbr_poly[2].y = misc->view_area_mbr.max_y;
-      mbr_poly[3].x = misc->view_area_mbr.max_x;
-      mbr_poly[3].y = misc->view_area_mbr.min_y;
-
-      int32_t poly_size = (int32_t) options->polygon.size ();
-
-      if (!polygon_intersection (mbr_poly, 4, options->polygon.data (), poly_size)) misc->view_flag = false;
-
-
-      //  Figure out how many iterations it will take to do the build so that we can set up a progress bar.
-
-      misc->poly_iterations = 1;
-      uint8_t done = false, direction = 0;
-      NV_F64_XYMBR test_mbr = misc->view_area_mbr;
-
-
-      /*  Debuggery
-
-      FILE *fp;
-      char name[1024];
-      sprintf(name, "000_MBR.are");
-      fp = fopen (name, "w");
-      fprintf(fp,"%.11f,%.11f\n",misc->build_area_mbr.min_y,misc->build_area_mbr.min_x);
-      fprintf(fp,"%.11f,%.11f\n",misc->build_area_mbr.max_y,misc->build_area_mbr.min_x);
-      fprintf(fp,"%.11f,%.11f\n",misc->build_area_mbr.max_y,misc->build_area_mbr.max_x);
-      fprintf(fp,"%.11f,%.11f\n",misc->build_area_mbr.min_y,misc->build_area_mbr.max_x);
-      fclose (fp);
-
-      sprintf(name, "Area_000.are");
-      fp = fopen (name, "w");
-      fprintf(fp,"%.11f,%.11f\n",test_mbr.min_y,test_mbr.min_x);
-      fprintf(fp,"%.11f,%.11f\n",test_mbr.max_y,test_mbr.min_x);
-      fprintf(fp,"%.11f,%.11f\n",test_mbr.max_y,test_mbr.max_x);
-      fprintf(fp,"%.11f,%.11f\n",test_mbr.min_y,test_mbr.max_x);
-      fclose (fp);
-
-      */
-
-      do
-        {
-          switch (direction)
-            {
-            case 0:
-
-              //  Move right one box
-
-              test_mbr.min_x += misc->box_size_x_deg;
-
-
-              //  If we've passed the end of the area...
-
-              if (test_mbr.max_x >= misc->build_area_mbr.max_x)
-                {
-                  //  Reset min_x to the previous location.
-
-                  test_mbr.min_x -= misc->box_size_x_deg;
-
-
-                  //  Move up one box
-
-                  test_mbr.min_y += misc->box_size_y_deg;
-
-
-                  //  If we've passed the top of the area, finish.
-
-                  if (test_mbr.min_y >= misc->build_area_mbr.max_y)
-                    {
-                      done = true;
-                    }
-                  else
-                    {
-                      direction = 1;
-                    }
-                }
-
-              break;
-
-            case 1:
-
-              //  Move left one box
-
-              test_mbr.min_x -= misc->box_size_x_deg;
-
-
-              //  If we've passed the end of the area...
-
-              if (test_mbr.max_x <= misc->build_area_mbr.min_x)
-                {
-                  //  Reset min_x to the previous location.
-
-                  test_mbr.min_x += misc->box_size_x_deg;
-
-
-                  //  Move up one box
-
-                  test_mbr.min_y += misc->box_size_y_deg;
-
-
-                  //  If we've passed the top of the area, finish.
-
-                  if (test_mbr.min_y >= misc->build_area_mbr.max_y)
-                    {
-                      done = true;
-                    }
-                  else
-                    {
-                      direction = 0;
-                    }
-                }
-
-              break;
-            }
-
-          test_mbr.max_y = test_mbr.min_y + misc->box_size_y_deg;
-          test_mbr.max_x = test_mbr.min_x + misc->box_size_x_deg;
-
-
-          //  Count the boxes that will actually get viewed.
-
-          NV_F64_COORD2 mbr_poly[4];
-
-          mbr_poly[0].x = test_mbr.min_x;
-          mbr_poly[0].y = test_mbr.min_y;
-          mbr_poly[1].x = test_mbr.min_x;
-          mbr_poly[1].y = test_mbr.max_y;
-          mbr_poly[2].x = test_mbr.max_x;
-          mbr_poly[2].y = test_mbr.max_y;
-          mbr_poly[3].x = test_mbr.max_x;
-          mbr_poly[3].y = test_mbr.min_y;
-
-          int32_t poly_size = (int32_t) options->polygon.size ();
-
-          if (polygon_intersection (mbr_poly, 4, options->polygon.data (), poly_size))
-            {
-              /*  Debuggery
+      //  Compute a rough estimate of how long this will take.
 
-              sprintf(name, "Area_%03d.are", misc->poly_iterations);
-              fp = fopen (name, "w");
-              fprintf(fp,"%.11f,%.11f\n",test_mbr.min_y,test_mbr.min_x);
-              fprintf(fp,"%.11f,%.11f\n",test_mbr.max_y,test_mbr.min_x);
-              fprintf(fp,"%.11f,%.11f\n",test_mbr.max_y,test_mbr.max_x);
-              fprintf(fp,"%.11f,%.11f\n",test_mbr.min_y,test_mbr.max_x);
-              fclose (fp);
+      misc->total_poly_time = misc->poly_iterations * options->cache_update_frequency + 20;
+    }
 
-              */
+  return (true);
+}
 
-              misc->poly_iterations++;
-            }
 
-        } while (!done);
 
 
-      //  Compute a rough estimate of how long this will take.
+/*!
+  Makes sure that misc->plan is the plan for the build that computeSize last sized (the rectangle or the polygon).  This has to be
+  called before starting a build since computeSize doesn't generate the rectangle plan.  If the plan is already current this costs
+  nothing.  Returns false if the plan couldn't be made (we ran out of memory).
+*/
 
-      misc->total_poly_time = misc->poly_iterations * options->cache_update_frequency + 20;
+uint8_t setBuildPlan (MISC *misc, OPTIONS *options)
+{
+  std::vector<int32_t> box_size;
+  levelBoxSizes (options, &box_size);
 
+  COVERAGE_INDEX *coverage = NULL;
+  if (options->incremental_build) coverage = &misc->coverage;
 
-      int32_t hour = misc->total_poly_time / 3600;
-      int32_t minute = (misc->total_poly_time / 60) % 60;
-      int32_t second = misc->total_poly_time % 60;
+  std::vector<NV_F64_COORD2> *polygon = NULL;
+  if (misc->poly_flag) polygon = &options->polygon;
 
-      misc->polyEstTime->setText (geCache::tr ("Estimated time to build = %1:%2:%3").arg (hour, 2, 10, zero).arg (minute, 2, 10, zero).arg (second, 2, 10, zero));
-      misc->numBoxes->setText (QString ("Number of areas = %1").arg (misc->poly_iterations));
-    }
+  return (makeBuildPlan (&misc->plan, misc->build_area_mbr, &box_size, polygon, options->build_order, coverage));
 }
@@ -24,9 +24,200 @@
 *********************************************************************************************/
 
 
-#include "geCacheDef.hpp"
+#include "geCacheEngine.hpp"
 
-uint8_t copyDir (const QString &source, const QString &dest)
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <linux/fs.h>
+
+#endif
+
+
+/*!
+  These functions copy a directory tree.  On Linux each file is first cloned with the FICLONE ioctl (a reflink on btrfs or XFS,
+  which shares the data blocks and takes no time regardless of the file size).  If the file system can't do that we try
+  copy_file_range, which copies the data inside the kernel (and lets NFS and some other file systems do a server side copy).  If
+  neither works we fall back to QFile::copy.  The strategy used for each file is counted in stats (if it isn't NULL) so that
+  the caller can tell the user how the copy was done.
+
+  snapshotDir is the same thing except that, on Linux, the leveldb table files are hard linked instead of copied.  Google Earth
+  never changes a table file after it has been written (it only creates and deletes them) so the snapshot can share them with the
+  cache.  Everything else (the dbCache files, the leveldb logs and manifests) is written in place so it has to be cloned or copied
+  or the snapshot would change along with the cache.
+
+  CopyEngine does the same copy for saving and loading caches, where the user is waiting on it.  It walks the tree once, makes all
+  of the directories, and then copies the files on a small thread pool (one thread if either end is on a spinning disk since
+  parallel copies just make the heads thrash).  The caller polls it for progress and can cancel it, in which case (or if the copy
+  fails) the partial copy is removed.  The copy can be held to a maximum bandwidth.
+*/
+
+#define COPY_THREADS      4
+
+#ifdef __linux__
+
+//  Try to copy source to dest without moving the data through user space.  Returns COPY_REFLINK or COPY_FILE_RANGE if it worked,
+//  COPY_QFILE if we should fall back to QFile::copy, COPY_SKIPPED if source isn't there anymore, or -1 if the copy failed.
+
+static int32_t copyFileNative (const QString &source, const QString &dest, int64_t *size)
+{
+  struct stat st;
+
+
+  int32_t src_fd = open (QFile::encodeName (source).constData (), O_RDONLY | O_CLOEXEC);
+
+  if (src_fd < 0) return (errno == ENOENT ? COPY_SKIPPED : -1);
+
+  if (fstat (src_fd, &st))
+    {
+      close (src_fd);
+      return (-1);
+    }
+
+  *size = (int64_t) st.st_size;
+
+
+  int32_t dst_fd = open (QFile::encodeName (dest).constData (), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 0777);
+
+  if (dst_fd < 0)
+    {
+      close (src_fd);
+      return (-1);
+    }
+
+
+#ifdef FICLONE
+
+  if (!ioctl (dst_fd, FICLONE, src_fd))
+    {
+      close (src_fd);
+      close (dst_fd);
+      return (COPY_REFLINK);
+    }
+
+#endif
+
+
+#ifdef __NR_copy_file_range
+
+  int64_t copied = 0;
+
+  while (copied < (int64_t) st.st_size)
+    {
+      ssize_t count = syscall (__NR_copy_file_range, src_fd, NULL, dst_fd, NULL, (size_t) (st.st_size - copied), 0);
+
+      if (count < 0)
+        {
+          //  If the kernel or the file system can't do it (or the files are on different file systems with an older kernel) and we
+          //  haven't copied anything yet, we'll let QFile::copy do it.  An error after part of the file has been copied is a
+          //  real error.
+
+          if (!copied && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP || errno == EINVAL)) break;
+
+          close (src_fd);
+          close (dst_fd);
+          unlink (QFile::encodeName (dest).constData ());
+          return (-1);
+        }
+
+      if (!count) break;
+
+      copied += count;
+    }
+
+  close (src_fd);
+  close (dst_fd);
+
+  if (copied && copied == (int64_t) st.st_size) return (COPY_FILE_RANGE);
+
+#else
+
+  close (src_fd);
+  close (dst_fd);
+
+#endif
+
+
+  //  Get rid of the empty (or partial) file so that QFile::copy can create it.
+
+  unlink (QFile::encodeName (dest).constData ());
+
+  return (COPY_QFILE);
+}
+
+#endif
+
+
+
+//  Copy one file.  If link_file is set and the file is one that is never written in place it is hard linked.  Google Earth may still
+//  be running (e.g. when an unattended build saves a segment) so a file that it deleted after we listed it is counted as skipped
+//  instead of failing the copy.  Returns false if the copy failed.
+
+static uint8_t copyFile (const QString &source, const QString &dest, COPY_STATS *stats, uint8_t link_file)
+{
+  int32_t strategy = COPY_QFILE;
+  int64_t size = 0;
+
+
+#ifdef __linux__
+
+  if (link_file && (source.endsWith (".ldb") || source.endsWith (".sst")) &&
+      !link (QFile::encodeName (source).constData (), QFile::encodeName (dest).constData ()))
+    {
+      if (stats)
+        {
+          stats->files[COPY_HARDLINK]++;
+          stats->bytes[COPY_HARDLINK] += QFileInfo (dest).size ();
+        }
+
+      return (true);
+    }
+
+  strategy = copyFileNative (source, dest, &size);
+
+  if (strategy == COPY_SKIPPED)
+    {
+      if (stats) stats->skipped++;
+
+      return (true);
+    }
+
+  if (strategy < 0) return (false);
+
+#endif
+
+  if (strategy == COPY_QFILE)
+    {
+      if (!QFile::copy (source, dest))
+        {
+          if (QFileInfo::exists (source)) return (false);
+
+          if (stats) stats->skipped++;
+
+          return (true);
+        }
+
+      size = QFileInfo (dest).size ();
+    }
+
+  if (stats)
+    {
+      stats->files[strategy]++;
+      stats->bytes[strategy] += size;
+    }
+
+  return (true);
+}
+
+
+
+static uint8_t copyTree (const QString &source, const QString &dest, COPY_STATS *stats, uint8_t link_files)
 {
   QFileInfo sourceInfo (source);
 
@@ -47,13 +238,358 @@ uint8_t copyDir (const QString &source, const QString &dest)
           const QString newSource = source + SEPARATOR + file;
           const QString newDest = dest + SEPARATOR + file;
 
-          if (!copyDir (newSource, newDest)) return (false);
+          if (!copyTree (newSource, newDest, stats, link_files)) return (false);
         }
     }
   else
     {
-      if (!QFile::copy (source, dest)) return (false);
+      if (!copyFile (source, dest, stats, link_files)) return (false);
+    }
+
+  return (true);
+}
+
+
+
+uint8_t copyDir (const QString &source, const QString &dest, COPY_STATS *stats)
+{
+  return (copyTree (source, dest, stats, false));
+}
+
+
+
+uint8_t snapshotDir (const QString &source, const QString &dest, COPY_STATS *stats)
+{
+  return (copyTree (source, dest, stats, true));
+}
+
+
+
+/*!
+  Puts new_dir in place of dir by renaming dir to old_dir and then new_dir to dir.  All three have to be in the same parent
+  directory so that each rename is atomic and nothing ever sees a half copied directory.  If either rename fails (e.g. on Windows
+  when something has a file in dir open) everything is put back where it was and we return false.
+*/
+
+uint8_t swapDir (const QString &new_dir, const QString &dir, const QString &old_dir)
+{
+  QDir parent;
+
+
+  if (!parent.rename (dir, old_dir)) return (false);
+
+  if (!parent.rename (new_dir, dir))
+    {
+      parent.rename (old_dir, dir);
+      return (false);
+    }
+
+  return (true);
+}
+
+
+
+void clearCopyStats (COPY_STATS *stats)
+{
+  for (int32_t i = 0 ; i < COPY_STRATEGIES ; i++)
+    {
+      stats->files[i] = 0;
+      stats->bytes[i] = 0;
+    }
+
+  stats->skipped = 0;
+}
+
+
+
+//  A short description of how a copy was done (e.g. "1204 files (1874.2M) reflinked, 3 files (0.1M) copied").
+
+QString copyStatsText (COPY_STATS *stats)
+{
+  QStringList text;
+
+
+  for (int32_t i = 0 ; i < COPY_STRATEGIES ; i++)
+    {
+      if (!stats->files[i]) continue;
+
+      QString size = QString::number ((double) stats->bytes[i] / 1048576.0, 'f', 1);
+
+      switch (i)
+        {
+        case COPY_QFILE:
+          text += QCoreApplication::translate ("geCache", "%1 files (%2M) copied").arg (stats->files[i]).arg (size);
+          break;
+
+        case COPY_REFLINK:
+          text += QCoreApplication::translate ("geCache", "%1 files (%2M) reflinked").arg (stats->files[i]).arg (size);
+          break;
+
+        case COPY_FILE_RANGE:
+          text += QCoreApplication::translate ("geCache", "%1 files (%2M) copied in the kernel").arg (stats->files[i]).arg (size);
+          break;
+
+        case COPY_HARDLINK:
+          text += QCoreApplication::translate ("geCache", "%1 files (%2M) hard linked").arg (stats->files[i]).arg (size);
+          break;
+        }
+    }
+
+  if (stats->skipped) text += QCoreApplication::translate ("geCache", "%1 files skipped (deleted before they could be copied)").arg (stats->skipped);
+
+  if (text.isEmpty ()) return (QCoreApplication::translate ("geCache", "no files copied"));
+
+  return (text.join (", "));
+}
+
+
+
+#ifdef __linux__
+
+//  Returns true if the file system that path is on is a spinning disk (per /sys/dev/block/MAJOR:MINOR/queue/rotational).  For a
+//  partition the queue directory is in the parent (whole disk) directory.
+
+static uint8_t rotationalDisk (const QString &path)
+{
+  struct stat st;
+
+
+  if (stat (QFile::encodeName (path).constData (), &st)) return (false);
+
+  QString dev = QString ("/sys/dev/block/%1:%2").arg (major (st.st_dev)).arg (minor (st.st_dev));
+
+  QString name = dev + "/queue/rotational";
+  if (!QFileInfo (name).exists ()) name = dev + "/../queue/rotational";
+
+  QFile file (name);
+
+  if (!file.open (QIODevice::ReadOnly)) return (false);
+
+  uint8_t rotational = (file.readAll ().trimmed () == "1");
+
+  file.close ();
+
+  return (rotational);
+}
+
+#endif
+
+
+
+//  Copies files from the engine's list until the list is empty, the copy has been canceled, or a copy fails.
+
+class CopyWorker:public QRunnable
+{
+public:
+
+  CopyWorker (CopyEngine *copy_engine)
+  {
+    engine = copy_engine;
+  }
+
+  void run ()
+  {
+    COPY_STATS stats;
+
+    clearCopyStats (&stats);
+
+    while (!engine->cancel_flag.load ())
+      {
+        int32_t i = engine->next_file.fetchAndAddOrdered (1);
+
+        if (i >= (int32_t) engine->file.size ()) break;
+
+        if (!copyFile (engine->source + SEPARATOR + engine->file[i], engine->dest + SEPARATOR + engine->file[i], &stats, engine->link_files))
+          {
+            engine->error_flag.store (1);
+            engine->cancel_flag.store (1);
+            break;
+          }
+
+        engine->files_done.fetchAndAddOrdered (1);
+        int64_t done = engine->bytes_done.fetchAndAddOrdered (engine->file_size[i]) + engine->file_size[i];
+
+
+        //  If we're ahead of the bandwidth limit, wait until we aren't (checking for a cancel now and then).
+
+        if (engine->bandwidth_limit)
+          {
+            int64_t due = done * 1000 / ((int64_t) engine->bandwidth_limit * 1048576);
+
+            while (!engine->cancel_flag.load () && due > engine->timer.elapsed ())
+              QThread::msleep ((unsigned long) qMin ((int64_t) 100, due - engine->timer.elapsed ()));
+          }
+      }
+
+    QMutexLocker locker (&engine->stats_mutex);
+
+    for (int32_t i = 0 ; i < COPY_STRATEGIES ; i++)
+      {
+        engine->stats.files[i] += stats.files[i];
+        engine->stats.bytes[i] += stats.bytes[i];
+      }
+
+    engine->stats.skipped += stats.skipped;
+  }
+
+  CopyEngine *engine;
+};
+
+
+
+//  The bandwidth limit is in megabytes per second (0 for no limit).  If link is set the files are copied the way snapshotDir
+//  copies them.
+
+CopyEngine::CopyEngine (const QString &source_dir, const QString &dest_dir, int32_t limit, uint8_t link)
+{
+  source = source_dir;
+  dest = dest_dir;
+  bandwidth_limit = limit;
+  link_files = link;
+  total_files = 0;
+  total_bytes = 0;
+  threads = COPY_THREADS;
+  finished = false;
+  next_file.store (0);
+  files_done.store (0);
+  bytes_done.store (0);
+  cancel_flag.store (0);
+  error_flag.store (0);
+  clearCopyStats (&stats);
+}
+
+
+
+CopyEngine::~CopyEngine ()
+{
+  if (!finished)
+    {
+      cancel ();
+      wait (-1);
+    }
+}
+
+
+
+//  Size the source tree with sizeDirs (the same parallel sizing that the cache size tracker uses), make its directories in the
+//  destination, and add its files to the list.  Like sizeDirs, symbolic links inside the tree are skipped.
+
+uint8_t 
+CopyEngine::walk ()
+{
+  //  The source may be the link to a mounted cache so we size the directory that it points at.
+
+  QString root = QDir (source).canonicalPath ();
+
+  DIR_FILES dir_files;
+
+  sizeDirs (root, &dir_files);
+
+
+  if (!QDir ().mkpath (dest)) return (false);
+
+  for (DIR_FILES::const_iterator it = dir_files.constBegin () ; it != dir_files.constEnd () ; ++it)
+    {
+      QString dir = it.key ().mid (root.length () + 1);
+
+      if (!dir.isEmpty () && !QDir ().mkpath (dest + SEPARATOR + dir)) return (false);
+
+      for (QHash<QString, int64_t>::const_iterator f = it.value ().constBegin () ; f != it.value ().constEnd () ; ++f)
+        {
+          try
+            {
+              file.push_back (dir.isEmpty () ? f.key () : dir + SEPARATOR + f.key ());
+              file_size.push_back (f.value ());
+            }
+          catch (std::bad_alloc&)
+            {
+              return (false);
+            }
+
+          total_bytes += f.value ();
+        }
     }
 
   return (true);
 }
+
+
+
+//  Walk the source tree and start copying.  Returns false if the source isn't a directory or the destination directories
+//  couldn't be made.
+
+uint8_t 
+CopyEngine::start ()
+{
+  if (!QFileInfo (source).isDir ()) return (false);
+
+  if (!walk ())
+    {
+      removeDirLater (dest);
+      return (false);
+    }
+
+  total_files = (int32_t) file.size ();
+
+
+#ifdef __linux__
+
+  if (rotationalDisk (source) || rotationalDisk (dest)) threads = 1;
+
+#endif
+
+  threads = qMax (1, qMin (threads, total_files));
+
+  pool.setMaxThreadCount (threads);
+
+  timer.start ();
+
+  for (int32_t i = 0 ; i < threads ; i++) pool.start (new CopyWorker (this));
+
+  return (true);
+}
+
+
+
+//  Wait up to msecs milliseconds for the copy to finish.  Returns true when it has finished (or been canceled).  If it didn't
+//  work out the partial copy is removed.
+
+uint8_t 
+CopyEngine::wait (int32_t msecs)
+{
+  if (finished) return (true);
+
+  if (!pool.waitForDone (msecs)) return (false);
+
+  finished = true;
+
+  if (cancel_flag.load ()) removeDirLater (dest);
+
+  return (true);
+}
+
+
+
+void 
+CopyEngine::cancel ()
+{
+  cancel_flag.store (1);
+}
+
+
+
+//  Returns true if every file was copied.
+
+uint8_t 
+CopyEngine::succeeded ()
+{
+  return (finished && !cancel_flag.load ());
+}
+
+
+
+uint8_t 
+CopyEngine::canceled ()
+{
+  return (cancel_flag.load () && !error_flag.load ());
+}
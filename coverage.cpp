@@ -0,0 +1,407 @@
+
+/********************************************************************************************* 
+
+    coverage.cpp
+
+    Copyright (c) 2016, Jan C. Depner
+
+
+    This file is part of geCache.
+
+    geCache is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    geCache is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with geCache.  If not, see <http://www.gnu.org/licenses/>.
+
+*********************************************************************************************/
+
+
+
+#include "geCacheEngine.hpp"
+
+
+/*!
+  These functions maintain the coverage index for a Google Earth cache directory.  The coverage index is a list of every box that
+  has been displayed (and therefore cached) along with the box size (in meters) that was used for it.  It is stored in a text file
+  next to the cache directory (the same way the _geCache.kml area file is stored next to a saved cache) so that it travels with the
+  cache when it is saved or loaded.  When an incremental build is planned, any box that is already covered by boxes of the same or
+  finer resolution is dropped from the plan.
+*/
+
+QString coverageName (const QString &cache_dir)
+{
+  return (cache_dir + "_geCache.cov");
+}
+
+
+
+void clearCoverage (COVERAGE_INDEX *coverage)
+{
+  coverage->box.clear ();
+  coverage->bucket_start.clear ();
+  coverage->bucket_box.clear ();
+  coverage->dirty = true;
+  coverage->serial++;
+}
+
+
+
+//  Add the boxes from start to end - 1 of the plan to the coverage index.  Returns false if we ran out of memory (some of the
+//  boxes may not have been added).
+
+uint8_t addCoverage (COVERAGE_INDEX *coverage, BUILD_PLAN *plan, int32_t start, int32_t end)
+{
+  uint8_t status = true;
+
+
+  end = qMin (end, (int32_t) plan->box.size ());
+
+  for (int32_t i = qMax (0, start) ; i < end ; i++)
+    {
+      COVERAGE_BOX box;
+
+      box.mbr = plan->box[i].mbr;
+      box.box_size = plan->level_box_size[plan->box[i].level];
+
+      try
+        {
+          coverage->box.push_back (box);
+        }
+      catch (std::bad_alloc&)
+        {
+          status = false;
+          break;
+        }
+    }
+
+  coverage->dirty = true;
+  coverage->serial++;
+
+  return (status);
+}
+
+
+
+//  Read the coverage index for cache_dir.  Returns false (with an empty index) if there isn't one or we ran out of memory.
+
+uint8_t readCoverage (const QString &cache_dir, COVERAGE_INDEX *coverage)
+{
+  FILE *fp;
+  char fname[1024], str[256];
+
+
+  clearCoverage (coverage);
+
+  strcpy (fname, coverageName (cache_dir).toLocal8Bit ());
+
+  if ((fp = fopen (fname, "r")) == NULL) return (false);
+
+  while (fgets (str, sizeof (str), fp) != NULL)
+    {
+      COVERAGE_BOX box;
+
+      if (sscanf (str, "%d %lf %lf %lf %lf", &box.box_size, &box.mbr.min_y, &box.mbr.min_x, &box.mbr.max_y, &box.mbr.max_x) != 5) continue;
+
+      try
+        {
+          coverage->box.push_back (box);
+        }
+      catch (std::bad_alloc&)
+        {
+          fclose (fp);
+          clearCoverage (coverage);
+          return (false);
+        }
+    }
+
+  fclose (fp);
+
+  return (true);
+}
+
+
+
+uint8_t writeCoverage (const QString &cache_dir, COVERAGE_INDEX *coverage)
+{
+  FILE *fp;
+  char fname[1024];
+
+
+  strcpy (fname, coverageName (cache_dir).toLocal8Bit ());
+
+
+  //  If there's nothing in the cache there's no point in having an index.
+
+  if (!coverage->box.size ())
+    {
+      remove (fname);
+      return (true);
+    }
+
+  if ((fp = fopen (fname, "w")) == NULL) return (false);
+
+  fprintf (fp, "# geCache coverage index - box size (meters), south, west, north, east\n");
+
+  for (uint32_t i = 0 ; i < coverage->box.size () ; i++)
+    {
+      fprintf (fp, "%d %.11f %.11f %.11f %.11f\n", coverage->box[i].box_size, coverage->box[i].mbr.min_y, coverage->box[i].mbr.min_x,
+               coverage->box[i].mbr.max_y, coverage->box[i].mbr.max_x);
+    }
+
+  fclose (fp);
+
+  return (true);
+}
+
+
+
+/*!
+  Builds the grid that is used to find the boxes near a point.  The grid cells are the size of the smallest box in the index (or
+  bigger if that would make the grid much larger than the number of boxes) and every box is put in every cell that it overlaps.
+  This is done automatically the first time the index is used after boxes have been added.  Returns false if we ran out of memory
+  (the index is left dirty and empty).
+*/
+
+uint8_t indexCoverage (COVERAGE_INDEX *coverage)
+{
+  int32_t count = (int32_t) coverage->box.size ();
+
+  coverage->dirty = false;
+  coverage->bucket_start.clear ();
+  coverage->bucket_box.clear ();
+
+  if (!count) return (true);
+
+
+  double min_w = 999.0, min_h = 999.0;
+
+  coverage->mbr = coverage->box[0].mbr;
+
+  for (int32_t i = 0 ; i < count ; i++)
+    {
+      NV_F64_XYMBR *mbr = &coverage->box[i].mbr;
+
+      coverage->mbr.min_x = qMin (coverage->mbr.min_x, mbr->min_x);
+      coverage->mbr.max_x = qMax (coverage->mbr.max_x, mbr->max_x);
+      coverage->mbr.min_y = qMin (coverage->mbr.min_y, mbr->min_y);
+      coverage->mbr.max_y = qMax (coverage->mbr.max_y, mbr->max_y);
+
+      min_w = qMin (min_w, mbr->max_x - mbr->min_x);
+      min_h = qMin (min_h, mbr->max_y - mbr->min_y);
+    }
+
+  coverage->cell_x = qMax (min_w, 0.0000001);
+  coverage->cell_y = qMax (min_h, 0.0000001);
+
+
+  //  Don't let a few tiny boxes spread over a huge area blow up the grid.
+
+  while (true)
+    {
+      coverage->cols = (int32_t) ((coverage->mbr.max_x - coverage->mbr.min_x) / coverage->cell_x) + 1;
+      coverage->rows = (int32_t) ((coverage->mbr.max_y - coverage->mbr.min_y) / coverage->cell_y) + 1;
+
+      if ((int64_t) coverage->cols * (int64_t) coverage->rows <= 4 * (int64_t) count + 1024) break;
+
+      coverage->cell_x *= 2.0;
+      coverage->cell_y *= 2.0;
+    }
+
+
+  int32_t cells = coverage->rows * coverage->cols;
+
+  try
+    {
+      coverage->bucket_start.assign (cells + 1, 0);
+    }
+  catch (std::bad_alloc&)
+    {
+      coverage->dirty = true;
+      return (false);
+    }
+
+
+  //  Two passes, count the boxes in each cell and then fill them in.
+
+  for (int32_t pass = 0 ; pass < 2 ; pass++)
+    {
+      std::vector<int32_t> fill;
+
+      if (pass)
+        {
+          for (int32_t i = 0 ; i < cells ; i++) coverage->bucket_start[i + 1] += coverage->bucket_start[i];
+
+          try
+            {
+              coverage->bucket_box.resize (coverage->bucket_start[cells]);
+              fill.assign (coverage->bucket_start.begin (), coverage->bucket_start.end () - 1);
+            }
+          catch (std::bad_alloc&)
+            {
+              coverage->dirty = true;
+              coverage->bucket_start.clear ();
+              coverage->bucket_box.clear ();
+              return (false);
+            }
+        }
+
+      for (int32_t i = 0 ; i < count ; i++)
+        {
+          NV_F64_XYMBR *mbr = &coverage->box[i].mbr;
+
+          int32_t col_start = (int32_t) ((mbr->min_x - coverage->mbr.min_x) / coverage->cell_x);
+          int32_t col_end = qMin (coverage->cols - 1, (int32_t) ((mbr->max_x - coverage->mbr.min_x) / coverage->cell_x));
+          int32_t row_start = (int32_t) ((mbr->min_y - coverage->mbr.min_y) / coverage->cell_y);
+          int32_t row_end = qMin (coverage->rows - 1, (int32_t) ((mbr->max_y - coverage->mbr.min_y) / coverage->cell_y));
+
+          for (int32_t row = row_start ; row <= row_end ; row++)
+            {
+              for (int32_t col = col_start ; col <= col_end ; col++)
+                {
+                  int32_t cell = row * coverage->cols + col;
+
+                  if (pass)
+                    {
+                      coverage->bucket_box[fill[cell]++] = i;
+                    }
+                  else
+                    {
+                      coverage->bucket_start[cell + 1]++;
+                    }
+                }
+            }
+        }
+    }
+
+  return (true);
+}
+
+
+
+/*!
+  Returns true if the box (with a box size of box_size meters) is already covered by the boxes in the index.  The boxes from
+  earlier builds won't line up with the boxes in a new plan so we start with the box and cut out every box of the same or finer
+  resolution that overlaps it.  The box is only covered if nothing is left (slivers thinner than COVERAGE_SLIVER degrees, left
+  over from rounding where boxes share an edge, don't count).
+*/
+
+uint8_t boxCovered (COVERAGE_INDEX *coverage, NV_F64_XYMBR *mbr, int32_t box_size)
+{
+  //  If the index couldn't be built (see makeLevel) we just say the box isn't covered.
+
+  if (coverage->dirty && !indexCoverage (coverage)) return (false);
+
+  if (!coverage->box.size ()) return (false);
+
+  if (mbr->min_x < coverage->mbr.min_x - COVERAGE_SLIVER || mbr->max_x > coverage->mbr.max_x + COVERAGE_SLIVER ||
+      mbr->min_y < coverage->mbr.min_y - COVERAGE_SLIVER || mbr->max_y > coverage->mbr.max_y + COVERAGE_SLIVER) return (false);
+
+
+  //  Get the boxes that overlap the box from the grid cells that it touches.
+
+  int32_t col_start = qMax (0, (int32_t) ((mbr->min_x - coverage->mbr.min_x) / coverage->cell_x));
+  int32_t col_end = qMin (coverage->cols - 1, (int32_t) ((mbr->max_x - coverage->mbr.min_x) / coverage->cell_x));
+  int32_t row_start = qMax (0, (int32_t) ((mbr->min_y - coverage->mbr.min_y) / coverage->cell_y));
+  int32_t row_end = qMin (coverage->rows - 1, (int32_t) ((mbr->max_y - coverage->mbr.min_y) / coverage->cell_y));
+
+  std::vector<int32_t> near;
+
+  for (int32_t row = row_start ; row <= row_end ; row++)
+    {
+      for (int32_t col = col_start ; col <= col_end ; col++)
+        {
+          int32_t cell = row * coverage->cols + col;
+
+          for (int32_t i = coverage->bucket_start[cell] ; i < coverage->bucket_start[cell + 1] ; i++)
+            {
+              COVERAGE_BOX *box = &coverage->box[coverage->bucket_box[i]];
+
+              if (box->box_size <= box_size && box->mbr.min_x < mbr->max_x && box->mbr.max_x > mbr->min_x &&
+                  box->mbr.min_y < mbr->max_y && box->mbr.max_y > mbr->min_y) near.push_back (coverage->bucket_box[i]);
+            }
+        }
+    }
+
+  std::sort (near.begin (), near.end ());
+  near.erase (std::unique (near.begin (), near.end ()), near.end ());
+
+
+  //  Cut each of the boxes out of what's left of the box (each piece that a box overlaps is replaced by up to four pieces around it).
+
+  std::vector<NV_F64_XYMBR> left, next;
+
+  left.push_back (*mbr);
+
+  for (uint32_t i = 0 ; i < near.size () && !left.empty () ; i++)
+    {
+      NV_F64_XYMBR *cut = &coverage->box[near[i]].mbr;
+
+      next.clear ();
+
+      for (uint32_t j = 0 ; j < left.size () ; j++)
+        {
+          NV_F64_XYMBR piece = left[j];
+
+          if (cut->min_x >= piece.max_x || cut->max_x <= piece.min_x || cut->min_y >= piece.max_y || cut->max_y <= piece.min_y)
+            {
+              next.push_back (piece);
+              continue;
+            }
+
+          NV_F64_XYMBR part;
+
+
+          //  South and north of the cut (full width), then west and east of it (between the two).
+
+          if (cut->min_y - piece.min_y > COVERAGE_SLIVER)
+            {
+              part = piece;
+              part.max_y = cut->min_y;
+              next.push_back (part);
+            }
+
+          if (piece.max_y - cut->max_y > COVERAGE_SLIVER)
+            {
+              part = piece;
+              part.min_y = cut->max_y;
+              next.push_back (part);
+            }
+
+          double min_y = qMax (piece.min_y, cut->min_y);
+          double max_y = qMin (piece.max_y, cut->max_y);
+
+          if (max_y - min_y > COVERAGE_SLIVER)
+            {
+              if (cut->min_x - piece.min_x > COVERAGE_SLIVER)
+                {
+                  part = piece;
+                  part.min_y = min_y;
+                  part.max_y = max_y;
+                  part.max_x = cut->min_x;
+                  next.push_back (part);
+                }
+
+              if (piece.max_x - cut->max_x > COVERAGE_SLIVER)
+                {
+                  part = piece;
+                  part.min_y = min_y;
+                  part.max_y = max_y;
+                  part.min_x = cut->max_x;
+                  next.push_back (part);
+                }
+            }
+        }
+
+      left.swap (next);
+    }
+
+  return (left.empty ());
+}
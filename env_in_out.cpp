@@ -24,7 +24,7 @@
 *********************************************************************************************/
 
 
-#include "geCache.hpp"
+#include "geCacheEngine.hpp"
 
 
 double settings_version = 1.00;
@@ -37,12 +37,14 @@ double settings_version = 1.00;
   force the defaults to be restored just change the settings_version to a newer number (I've been using the program
   version number from version.hpp - which you should be updating EVERY time you make a change to the program!).  You
   don't need to change the settings_version though unless you want to force the program to go back to the defaults
-  (which can annoy your users).  So, the settings_version won't always match the program version.
+  (which can annoy your users).  So, the settings_version won't always match the program version.  envin returns false if
+  there wasn't enough memory for the saved polygon (the polygon is cleared but everything else is read).
 */
 
 uint8_t envin (OPTIONS *options)
 {
   double saved_version = 0.0;
+  uint8_t polygon_ok = true;
 
 
   //  Get the INI file name
@@ -60,9 +62,10 @@ uint8_t envin (OPTIONS *options)
   saved_version = settings.value (QString ("settings version"), saved_version).toDouble ();
 
 
-  //  If the settings version has changed we need to leave the values at the new defaults since they may have changed.
+  //  If the settings version has changed we need to leave the values at the new defaults since they may have changed.  That's
+  //  not an error.
 
-  if (settings_version != saved_version) return (false);
+  if (settings_version != saved_version) return (true);
 
 
   options->position_form = settings.value (QString ("position form"), options->position_form).toInt ();
@@ -82,8 +85,11 @@ uint8_t envin (OPTIONS *options)
     }
   catch (std::bad_alloc&)
     {
-      QMessageBox::critical (0, geCache::tr ("geCache"), geCache::tr ("Unable to allocate polygon point memory!  Reason : %1").arg (strerror (errno)));
-      exit (-1);
+      //  This is also used by the batch build (where nobody can click on a message box) so we let the caller report it.
+
+      options->polygon.clear ();
+      size = 0;
+      polygon_ok = false;
     }
 
 
@@ -99,8 +105,23 @@ uint8_t envin (OPTIONS *options)
 
 
   options->cache_update_frequency = settings.value (QString ("cache update frequency"), options->cache_update_frequency).toInt ();
+  options->adaptive_dwell = settings.value (QString ("adaptive dwell"), options->adaptive_dwell).toBool ();
+  options->dwell_min = settings.value (QString ("minimum dwell"), options->dwell_min).toInt ();
+  options->dwell_settle = settings.value (QString ("dwell settle time"), options->dwell_settle).toInt ();
+  options->build_order = settings.value (QString ("build order"), options->build_order).toInt ();
+  options->incremental_build = settings.value (QString ("incremental build"), options->incremental_build).toBool ();
+  options->unattended_build = settings.value (QString ("unattended build"), options->unattended_build).toBool ();
+
+  QStringList levels = settings.value (QString ("pyramid levels"), QString ("")).toString ().split (",", QString::SkipEmptyParts);
+  options->pyramid_levels.clear ();
+  for (int32_t i = 0 ; i < levels.size () ; i++) options->pyramid_levels.push_back (levels.at (i).toInt ());
+
   options->build_box_size = settings.value (QString ("build box size"), options->build_box_size).toInt ();
   options->icon_size = settings.value (QString ("toolbar icon size"), options->icon_size).toInt ();
+  options->cache_size_limit = settings.value (QString ("cache size limit"), options->cache_size_limit).toInt ();
+  options->copy_bandwidth_limit = settings.value (QString ("copy bandwidth limit"), options->copy_bandwidth_limit).toInt ();
+  options->mount_cache = settings.value (QString ("mount cache"), options->mount_cache).toBool ();
+  options->mount_protect = settings.value (QString ("mount protect"), options->mount_protect).toBool ();
   options->start_tab = settings.value (QString ("start tab"), options->start_tab).toInt ();
   options->shape_tab = settings.value (QString ("shape tab"), options->shape_tab).toInt ();
 
@@ -126,7 +147,7 @@ uint8_t envin (OPTIONS *options)
   settings.endGroup ();
 
 
-  return (true);
+  return (polygon_ok);
 }
 
 
@@ -169,8 +190,23 @@ void envout (OPTIONS *options)
     }
 
   settings.setValue (QString ("cache update frequency"), options->cache_update_frequency);
+  settings.setValue (QString ("adaptive dwell"), options->adaptive_dwell);
+  settings.setValue (QString ("minimum dwell"), options->dwell_min);
+  settings.setValue (QString ("dwell settle time"), options->dwell_settle);
+  settings.setValue (QString ("build order"), options->build_order);
+  settings.setValue (QString ("incremental build"), options->incremental_build);
+  settings.setValue (QString ("unattended build"), options->unattended_build);
+
+  QStringList levels;
+  for (uint32_t i = 0 ; i < options->pyramid_levels.size () ; i++) levels += QString::number (options->pyramid_levels.at (i));
+  settings.setValue (QString ("pyramid levels"), levels.join (","));
+
   settings.setValue (QString ("build box size"), options->build_box_size);
   settings.setValue (QString ("toolbar icon size"), options->icon_size);
+  settings.setValue (QString ("cache size limit"), options->cache_size_limit);
+  settings.setValue (QString ("copy bandwidth limit"), options->copy_bandwidth_limit);
+  settings.setValue (QString ("mount cache"), options->mount_cache);
+  settings.setValue (QString ("mount protect"), options->mount_protect);
   settings.setValue (QString ("start tab"), options->start_tab);
   settings.setValue (QString ("shape tab"), options->shape_tab);
 
@@ -295,6 +295,242 @@ uint8_t polygon_intersection (NV_F64_COORD2 *poly1, int32_t poly1_count, NV_F64_
 
 
 
+
+/*  Polygon edge used by polygon_grid_coverage.  */
+
+typedef struct
+{
+  double          min_y;
+  double          max_y;
+  double          x0;
+  double          y0;
+  double          x1;
+  double          y1;
+} GRID_EDGE;
+
+
+static int32_t compare_edges (const void *a, const void *b)
+{
+  const GRID_EDGE *ea = (const GRID_EDGE *) a;
+  const GRID_EDGE *eb = (const GRID_EDGE *) b;
+
+  if (ea->min_y < eb->min_y) return (-1);
+  if (ea->min_y > eb->min_y) return (1);
+  return (0);
+}
+
+
+static int32_t compare_doubles (const void *a, const void *b)
+{
+  double da = *((const double *) a);
+  double db = *((const double *) b);
+
+  if (da < db) return (-1);
+  if (da > db) return (1);
+  return (0);
+}
+
+
+static void mark_cells (uint8_t *row_covered, int32_t cols, int32_t start, int32_t end)
+{
+  int32_t              i;
+
+
+  if (start < 0) start = 0;
+  if (end > cols - 1) end = cols - 1;
+
+  for (i = start ; i <= end ; i++) row_covered[i] = 1;
+}
+
+
+
+/***************************************************************************/
+/*!
+
+  - Module Name:        polygon_grid_coverage
+
+  - Programmer(s):      Jan C. Depner
+
+  - Date Written:       October 2026
+
+  - Purpose:            Marks the cells of a grid that overlap a polygon.
+                        All of the rows are the same height but each row
+                        may have its own cell width (so that the cells can
+                        be the same size on the ground at every latitude).
+                        This is a scanline (edge table) rasterizer so the
+                        cost is roughly proportional to the number of
+                        edges plus the number of covered cells instead of
+                        the number of cells times the number of edges
+                        (which is what you get by calling
+                        polygon_intersection for every cell).  For each
+                        row of cells, any cell that contains a piece of a
+                        polygon edge is covered.  Any other cell is either
+                        completely inside or completely outside of the
+                        polygon so we only have to check the center of the
+                        cell.  We do that by finding the spans of the
+                        polygon along the horizontal line through the
+                        centers of the cells in the row.
+
+  - Arguments:          poly         - polygon
+                        npol         - number of points in the polygon
+                        min_x        - western edge of the grid
+                        min_y        - southern edge of the grid
+                        dx           - array of cell widths (one for
+                                       each row)
+                        dy           - cell height
+                        cols         - number of columns in the grid (the
+                                       maximum number of cells in any row)
+                        rows         - number of rows in the grid
+                        covered      - rows * cols array (row major, row 0
+                                       is the southernmost row) that will be
+                                       set to 1 for covered cells and 0 for
+                                       all others
+
+  - Return Value:       0 on success, -1 on memory allocation failure
+
+  - Caveats:            The polygon may or may not be closed (i.e. the last
+                        point may or may not be the same as the first point).
+
+****************************************************************************/
+
+int32_t polygon_grid_coverage (NV_F64_COORD2 *poly, int32_t npol, double min_x, double min_y, double *dx, double dy, int32_t cols, int32_t rows,
+                               uint8_t *covered)
+{
+  GRID_EDGE            *edge;
+  int32_t              *active, *next_active, i, j, row, nedges, next_edge, nactive, count, ncross, start, end;
+  double               *cross, y0, y1, yc, ya, yb, xa, xb, lo, hi;
+
+
+  memset (covered, 0, (size_t) rows * (size_t) cols);
+
+  if (npol < 1 || rows < 1 || cols < 1) return (0);
+
+
+  edge = (GRID_EDGE *) malloc (npol * sizeof (GRID_EDGE));
+  active = (int32_t *) malloc (npol * sizeof (int32_t));
+  next_active = (int32_t *) malloc (npol * sizeof (int32_t));
+  cross = (double *) malloc (npol * sizeof (double));
+
+  if (edge == NULL || active == NULL || next_active == NULL || cross == NULL)
+    {
+      free (edge);
+      free (active);
+      free (next_active);
+      free (cross);
+      return (-1);
+    }
+
+
+  /*  Build the edge table (including the closing edge) sorted by the southern end of each edge.  */
+
+  nedges = 0;
+  for (i = 0, j = npol - 1 ; i < npol ; j = i++)
+    {
+      edge[nedges].x0 = poly[j].x;
+      edge[nedges].y0 = poly[j].y;
+      edge[nedges].x1 = poly[i].x;
+      edge[nedges].y1 = poly[i].y;
+      edge[nedges].min_y = (poly[j].y < poly[i].y) ? poly[j].y : poly[i].y;
+      edge[nedges].max_y = (poly[j].y < poly[i].y) ? poly[i].y : poly[j].y;
+      nedges++;
+    }
+
+  qsort (edge, nedges, sizeof (GRID_EDGE), (int (*)(const void *, const void *)) compare_edges);
+
+
+  next_edge = 0;
+  nactive = 0;
+
+  for (row = 0 ; row < rows ; row++)
+    {
+      y0 = min_y + (double) row * dy;
+      y1 = y0 + dy;
+      yc = y0 + dy * 0.5;
+
+
+      /*  Add any edges that start in (or below) this row to the active list.  */
+
+      while (next_edge < nedges && edge[next_edge].min_y <= y1) active[nactive++] = next_edge++;
+
+
+      /*  Drop the edges that end below this row.  */
+
+      count = 0;
+      for (i = 0 ; i < nactive ; i++)
+        {
+          if (edge[active[i]].max_y >= y0) next_active[count++] = active[i];
+        }
+      memcpy (active, next_active, count * sizeof (int32_t));
+      nactive = count;
+
+      if (!nactive) continue;
+
+
+      ncross = 0;
+
+      for (i = 0 ; i < nactive ; i++)
+        {
+          GRID_EDGE *e = &edge[active[i]];
+
+
+          /*  Mark the cells that contain the part of the edge that lies within this row.  */
+
+          if (e->y0 == e->y1)
+            {
+              xa = e->x0;
+              xb = e->x1;
+            }
+          else
+            {
+              ya = (e->min_y > y0) ? e->min_y : y0;
+              yb = (e->max_y < y1) ? e->max_y : y1;
+
+              xa = e->x0 + (e->x1 - e->x0) * (ya - e->y0) / (e->y1 - e->y0);
+              xb = e->x0 + (e->x1 - e->x0) * (yb - e->y0) / (e->y1 - e->y0);
+            }
+
+          lo = (xa < xb) ? xa : xb;
+          hi = (xa < xb) ? xb : xa;
+
+          start = (int32_t) floor ((lo - min_x) / dx[row]);
+          end = (int32_t) floor ((hi - min_x) / dx[row]);
+
+          if (end >= 0 && start < cols) mark_cells (&covered[row * cols], cols, start, end);
+
+
+          /*  Save the crossing of the center line (same half open rule as inside_polygon).  */
+
+          if ((e->y0 >= yc) != (e->y1 >= yc)) cross[ncross++] = e->x0 + (e->x1 - e->x0) * (yc - e->y0) / (e->y1 - e->y0);
+        }
+
+
+      /*  Mark the cells whose centers lie inside the polygon.  */
+
+      if (ncross > 1)
+        {
+          qsort (cross, ncross, sizeof (double), (int (*)(const void *, const void *)) compare_doubles);
+
+          for (i = 0 ; i < ncross - 1 ; i += 2)
+            {
+              start = (int32_t) ceil ((cross[i] - min_x) / dx[row] - 0.5);
+              end = (int32_t) floor ((cross[i + 1] - min_x) / dx[row] - 0.5);
+
+              if (end >= start && end >= 0 && start < cols) mark_cells (&covered[row * cols], cols, start, end);
+            }
+        }
+    }
+
+
+  free (edge);
+  free (active);
+  free (next_active);
+  free (cross);
+
+  return (0);
+}
+
+
+
 /******************************************************************************/
 
 void direct(double phi, double alam, double fazi, double s, double *phipri, double *alampr)
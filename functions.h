@@ -105,6 +105,8 @@ extern "C" {
 
 
   uint8_t polygon_intersection (NV_F64_COORD2 *poly1, int32_t npol1, NV_F64_COORD2 *poly2, int32_t npol2);
+  int32_t polygon_grid_coverage (NV_F64_COORD2 *poly, int32_t npol, double min_x, double min_y, double *dx, double dy, int32_t cols, int32_t rows,
+                                 uint8_t *covered);
   void direct(double phi, double alam, double fazi, double s, double *phipri, double *alampr);
   void invgp (double a0, double b0, double rlat1, double rlon1, double rlat2, double rlon2, double *dist, double *az);
   void newgp(double latobs, double lonobs, double az, double dist, double *lat, double *lon);
@@ -56,17 +56,15 @@ geCache::geCache (QWidget *parent):
   //  Initialize some important variables.
 
   googleEarthProc = NULL;
-  buildGoogleEarthProc = NULL;
-  build_direction = 0;
-  build_kill_flag = false;
-  build_start_flag = false;
+  resume_index = 0;
+  resume_box_count = 0;
+  resume_coverage_start = 0;
   bounds_clicked = NO_BOUNDS;
   poly_define = false;
   poly_edit = 0;
   prev_clipboard_text = "";
   restart_msg = false;
   already_gone = false;
-  x_box_count = 0;
 
 
   //  Trying to make QToolTips easier to read.
@@ -92,7 +90,19 @@ geCache::geCache (QWidget *parent):
 
   //  Get the user's defaults if available
 
-  envin (&options);
+  if (!envin (&options))
+    QMessageBox::warning (this, tr ("geCache"), tr ("Unable to allocate memory for the saved polygon!  The polygon has been cleared."));
+
+
+  //  Get the coverage index for whatever is in the Google Earth cache directory right now.
+
+  readCoverage (options.ge_dir, &misc.coverage);
+
+
+  //  Finish removing any old cache directories that an earlier run didn't get to (see removeDir.cpp).
+
+  sweepTombstones (QFileInfo (options.ge_dir).absolutePath ());
+  sweepTombstones (options.stash_dir);
 
 
   //  Set the window size and location from the saved settings
@@ -376,23 +386,23 @@ geCache::geCache (QWidget *parent):
   rectAreaInfoBox->setWhatsThis (tr ("Information about the size of the area and estimated duration of the cache build process"));
 
 
-  misc.meterWidth = new QLabel (tr ("Width = 000000.0 meters"), this);
-  misc.meterWidth->setToolTip (tr ("This is the width of the area in meters"));
-  misc.meterWidth->setWhatsThis (meterWidthText);
-  rectAreaInfoTopLayout->addWidget (misc.meterWidth);
-  rectAreaInfoTopLayout->setAlignment (misc.meterWidth, Qt::AlignCenter);
+  meterWidth = new QLabel (tr ("Width = 000000.0 meters"), this);
+  meterWidth->setToolTip (tr ("This is the width of the area in meters"));
+  meterWidth->setWhatsThis (meterWidthText);
+  rectAreaInfoTopLayout->addWidget (meterWidth);
+  rectAreaInfoTopLayout->setAlignment (meterWidth, Qt::AlignCenter);
 
-  misc.meterHeight = new QLabel (tr ("Height = 000000.0 meters"), this);
-  misc.meterHeight->setToolTip (tr ("This is the height of the area in meters"));
-  misc.meterHeight->setWhatsThis (meterHeightText);
-  rectAreaInfoMidLayout->addWidget (misc.meterHeight);
-  rectAreaInfoMidLayout->setAlignment (misc.meterHeight, Qt::AlignCenter);
+  meterHeight = new QLabel (tr ("Height = 000000.0 meters"), this);
+  meterHeight->setToolTip (tr ("This is the height of the area in meters"));
+  meterHeight->setWhatsThis (meterHeightText);
+  rectAreaInfoMidLayout->addWidget (meterHeight);
+  rectAreaInfoMidLayout->setAlignment (meterHeight, Qt::AlignCenter);
 
-  misc.rectEstTime = new QLabel (tr ("Estimated time to build = 00:00:00"), this);
-  misc.rectEstTime->setToolTip (tr ("This is the estimated amount of time it will take to build the cache"));
-  misc.rectEstTime->setWhatsThis (rectEstTimeText);
-  rectAreaInfoBotLayout->addWidget (misc.rectEstTime);
-  rectAreaInfoBotLayout->setAlignment (misc.rectEstTime, Qt::AlignCenter);
+  rectEstTime = new QLabel (tr ("Estimated time to build = 00:00:00"), this);
+  rectEstTime->setToolTip (tr ("This is the estimated amount of time it will take to build the cache"));
+  rectEstTime->setWhatsThis (rectEstTimeText);
+  rectAreaInfoBotLayout->addWidget (rectEstTime);
+  rectAreaInfoBotLayout->setAlignment (rectEstTime, Qt::AlignCenter);
 
 
   rectAreaBoxLayout->addWidget (rectAreaInfoBox, 10);
@@ -481,17 +491,17 @@ geCache::geCache (QWidget *parent):
   polyAreaInfoBox->setWhatsThis (tr ("Information about the size of the area and estimated duration of the cache build process"));
 
 
-  misc.numBoxes = new QLabel (tr ("Number of areas = 00000"), this);
-  misc.numBoxes->setToolTip (tr ("This is the number of areas used to completely cover the polygon"));
-  misc.numBoxes->setWhatsThis (numBoxesText);
-  polyAreaInfoTopLayout->addWidget (misc.numBoxes);
-  polyAreaInfoTopLayout->setAlignment (misc.numBoxes, Qt::AlignCenter);
+  numBoxes = new QLabel (tr ("Number of areas = 00000"), this);
+  numBoxes->setToolTip (tr ("This is the number of areas used to completely cover the polygon"));
+  numBoxes->setWhatsThis (numBoxesText);
+  polyAreaInfoTopLayout->addWidget (numBoxes);
+  polyAreaInfoTopLayout->setAlignment (numBoxes, Qt::AlignCenter);
 
-  misc.polyEstTime = new QLabel (tr ("Estimated time to build = 00:00:00"), this);
-  misc.polyEstTime->setToolTip (tr ("This is the estimated amount of time it will take to build the cache"));
-  misc.polyEstTime->setWhatsThis (polyEstTimeText);
-  polyAreaInfoBotLayout->addWidget (misc.polyEstTime);
-  polyAreaInfoBotLayout->setAlignment (misc.polyEstTime, Qt::AlignCenter);
+  polyEstTime = new QLabel (tr ("Estimated time to build = 00:00:00"), this);
+  polyEstTime->setToolTip (tr ("This is the estimated amount of time it will take to build the cache"));
+  polyEstTime->setWhatsThis (polyEstTimeText);
+  polyAreaInfoBotLayout->addWidget (polyEstTime);
+  polyAreaInfoBotLayout->setAlignment (polyEstTime, Qt::AlignCenter);
 
 
   polyAreaBoxLayout->addWidget (polyAreaInfoBox, 10);
@@ -538,6 +548,69 @@ geCache::geCache (QWidget *parent):
   cacheOpBoxLayout->addWidget (cufBox);
 
 
+  adaptiveBox = new QGroupBox (tr ("Adaptive dwell"), this);
+  adaptiveBox->setToolTip (tr ("Move to the next area as soon as Google Earth stops writing to the cache (minimum and settle time in seconds)"));
+  adaptiveBox->setWhatsThis (adaptiveDwellText);
+  adaptiveBox->setCheckable (true);
+  adaptiveBox->setChecked (options.adaptive_dwell);
+  connect (adaptiveBox, SIGNAL (clicked (bool)), this, SLOT (slotAdaptiveDwellClicked (bool)));
+  QHBoxLayout *adaptiveBoxLayout = new QHBoxLayout;
+  adaptiveBox->setLayout (adaptiveBoxLayout);
+
+  dwellMin = new QSpinBox (adaptiveBox);
+  dwellMin->setRange (1, 60);
+  dwellMin->setSingleStep (1);
+  dwellMin->setPrefix (tr ("Min "));
+  dwellMin->setWhatsThis (adaptiveDwellText);
+  dwellMin->setValue (options.dwell_min);
+  connect (dwellMin, SIGNAL (valueChanged (int)), this, SLOT (slotDwellMinChanged (int)));
+  adaptiveBoxLayout->addWidget (dwellMin);
+
+  dwellSettle = new QSpinBox (adaptiveBox);
+  dwellSettle->setRange (1, 30);
+  dwellSettle->setSingleStep (1);
+  dwellSettle->setPrefix (tr ("Settle "));
+  dwellSettle->setWhatsThis (adaptiveDwellText);
+  dwellSettle->setValue (options.dwell_settle);
+  connect (dwellSettle, SIGNAL (valueChanged (int)), this, SLOT (slotDwellSettleChanged (int)));
+  adaptiveBoxLayout->addWidget (dwellSettle);
+  cacheOpBoxLayout->addWidget (adaptiveBox);
+
+
+  QGroupBox *boBox = new QGroupBox (tr ("Cache build order"), this);
+  boBox->setToolTip (tr ("Change the order in which the areas are visited during the cache build process"));
+  boBox->setWhatsThis (buildOrderText);
+  QHBoxLayout *boBoxLayout = new QHBoxLayout;
+  boBox->setLayout (boBoxLayout);
+
+  buildOrder = new QComboBox (boBox);
+  buildOrder->setWhatsThis (buildOrderText);
+  buildOrder->setEditable (false);
+  buildOrder->addItem (tr ("Serpentine"));
+  buildOrder->addItem (tr ("Hilbert curve"));
+  buildOrder->addItem (tr ("Nearest neighbor"));
+  buildOrder->setCurrentIndex (options.build_order);
+  connect (buildOrder, SIGNAL (currentIndexChanged (int)), this, SLOT (slotBuildOrderChanged (int)));
+  boBoxLayout->addWidget (buildOrder);
+  cacheOpBoxLayout->addWidget (boBox);
+
+
+  QGroupBox *pyrBox = new QGroupBox (tr ("Pyramid build area sizes"), this);
+  pyrBox->setToolTip (tr ("Coarser area sizes (in meters, separated by commas) to be cached before the initial area size"));
+  pyrBox->setWhatsThis (pyramidLevelsText);
+  QHBoxLayout *pyrBoxLayout = new QHBoxLayout;
+  pyrBox->setLayout (pyrBoxLayout);
+
+  pyramidLevels = new QLineEdit (pyrBox);
+  pyramidLevels->setWhatsThis (pyramidLevelsText);
+  QStringList levels;
+  for (uint32_t i = 0 ; i < options.pyramid_levels.size () ; i++) levels += QString::number (options.pyramid_levels.at (i));
+  pyramidLevels->setText (levels.join (", "));
+  connect (pyramidLevels, SIGNAL (editingFinished ()), this, SLOT (slotPyramidLevelsEditingFinished ()));
+  pyrBoxLayout->addWidget (pyramidLevels);
+  cacheOpBoxLayout->addWidget (pyrBox);
+
+
 
   QHBoxLayout *loadBoxLayout = new QHBoxLayout;
   cacheBoxLayout->addLayout (loadBoxLayout);
@@ -547,6 +620,28 @@ geCache::geCache (QWidget *parent):
   connect (bBuildCache, SIGNAL (clicked ()), this, SLOT (slotBuildCache ()));
   loadBoxLayout->addWidget (bBuildCache);
 
+  bResumeBuild = new QPushButton (tr ("Resume build"), this);
+  bResumeBuild->setWhatsThis (resumeBuildText);
+  connect (bResumeBuild, SIGNAL (clicked ()), this, SLOT (slotResumeBuild ()));
+  loadBoxLayout->addWidget (bResumeBuild);
+
+  bQueueBuild = new QPushButton (tr ("Queue build"), this);
+  bQueueBuild->setWhatsThis (queueBuildText);
+  connect (bQueueBuild, SIGNAL (clicked ()), this, SLOT (slotQueueBuild ()));
+  loadBoxLayout->addWidget (bQueueBuild);
+
+  incrementalBuild = new QCheckBox (tr ("Incremental"), this);
+  incrementalBuild->setWhatsThis (incrementalBuildText);
+  incrementalBuild->setChecked (options.incremental_build);
+  connect (incrementalBuild, SIGNAL (clicked (bool)), this, SLOT (slotIncrementalBuildClicked (bool)));
+  loadBoxLayout->addWidget (incrementalBuild);
+
+  unattendedBuild = new QCheckBox (tr ("Unattended"), this);
+  unattendedBuild->setWhatsThis (unattendedBuildText);
+  unattendedBuild->setChecked (options.unattended_build);
+  connect (unattendedBuild, SIGNAL (clicked (bool)), this, SLOT (slotUnattendedBuildClicked (bool)));
+  loadBoxLayout->addWidget (unattendedBuild);
+
 
   //  Set the button colors for buttons with active/inactive processes.
 
@@ -580,6 +675,35 @@ geCache::geCache (QWidget *parent):
   connect (bLoadCache, SIGNAL (clicked ()), this, SLOT (slotLoadCacheClicked ()));
   loadBoxLayout->addWidget (bLoadCache);
 
+  mountCacheCheck = new QCheckBox (tr ("Mount"), this);
+  mountCacheCheck->setWhatsThis (mountCacheText);
+  mountCacheCheck->setChecked (options.mount_cache);
+  connect (mountCacheCheck, SIGNAL (clicked (bool)), this, SLOT (slotMountCacheClicked (bool)));
+  loadBoxLayout->addWidget (mountCacheCheck);
+
+  mountProtectCheck = new QCheckBox (tr ("Protect"), this);
+  mountProtectCheck->setWhatsThis (mountProtectText);
+  mountProtectCheck->setChecked (options.mount_protect);
+  mountProtectCheck->setEnabled (options.mount_cache);
+  connect (mountProtectCheck, SIGNAL (clicked (bool)), this, SLOT (slotMountProtectClicked (bool)));
+  loadBoxLayout->addWidget (mountProtectCheck);
+
+#ifdef _MSC_VER
+
+  mountCacheCheck->setChecked (false);
+  mountCacheCheck->setEnabled (false);
+  mountCacheCheck->setToolTip (tr ("Mounting saved caches is not available on Windows"));
+  mountProtectCheck->setChecked (false);
+  mountProtectCheck->setEnabled (false);
+  mountProtectCheck->setToolTip (tr ("Mounting saved caches is not available on Windows"));
+
+#else
+
+  mountCacheCheck->setToolTip (tr ("Point the Google Earth cache directory at saved caches instead of copying them"));
+  mountProtectCheck->setToolTip (tr ("Keep Google Earth from rewriting the index and lock files of a mounted saved cache"));
+
+#endif
+
 
   progBox = new QGroupBox (tr ("Cache build progress"), this);
   progBox->setToolTip (tr ("This is the progress bar for the cache build process"));
@@ -779,6 +903,43 @@ geCache::geCache (QWidget *parent):
   connect (iconSize, SIGNAL (currentIndexChanged (int)), this, SLOT (slotIconSizeChanged (int)));
 
 
+  QGroupBox *limitBox = new QGroupBox (tr ("Cache size limit"), this);
+  limitBox->setToolTip (tr ("Set the size (in megabytes) at which the cache has to be saved during a cache build"));
+  limitBox->setWhatsThis (cacheLimitText);
+  QHBoxLayout *limitBoxLayout = new QHBoxLayout;
+  limitBox->setLayout (limitBoxLayout);
+
+  cacheLimit = new QSpinBox (limitBox);
+  cacheLimit->setToolTip (tr ("Set the size (in megabytes) at which the cache has to be saved during a cache build"));
+  cacheLimit->setWhatsThis (cacheLimitText);
+  cacheLimit->setRange (100, 1000000);
+  cacheLimit->setSingleStep (100);
+  cacheLimit->setSuffix (tr (" MB"));
+  cacheLimit->setValue (options.cache_size_limit);
+  connect (cacheLimit, SIGNAL (valueChanged (int)), this, SLOT (slotCacheLimitChanged (int)));
+  limitBoxLayout->addWidget (cacheLimit);
+  opBoxLayout->addWidget (limitBox);
+
+
+  QGroupBox *copyLimitBox = new QGroupBox (tr ("Copy bandwidth limit"), this);
+  copyLimitBox->setToolTip (tr ("Set the maximum rate (in megabytes per second) for saving and loading caches"));
+  copyLimitBox->setWhatsThis (copyLimitText);
+  QHBoxLayout *copyLimitBoxLayout = new QHBoxLayout;
+  copyLimitBox->setLayout (copyLimitBoxLayout);
+
+  copyLimit = new QSpinBox (copyLimitBox);
+  copyLimit->setToolTip (tr ("Set the maximum rate (in megabytes per second) for saving and loading caches"));
+  copyLimit->setWhatsThis (copyLimitText);
+  copyLimit->setRange (0, 10000);
+  copyLimit->setSingleStep (10);
+  copyLimit->setSuffix (tr (" MB/s"));
+  copyLimit->setSpecialValueText (tr ("Unlimited"));
+  copyLimit->setValue (options.copy_bandwidth_limit);
+  connect (copyLimit, SIGNAL (valueChanged (int)), this, SLOT (slotCopyLimitChanged (int)));
+  copyLimitBoxLayout->addWidget (copyLimit);
+  opBoxLayout->addWidget (copyLimitBox);
+
+
   geCacheTab->addTab (prefBox, tr ("Preferences"));
   geCacheTab->setTabToolTip (PREF_TAB, tr ("Set geCache preferences"));
   geCacheTab->setTabWhatsThis (PREF_TAB, tr ("This tab is used to modify geCache preferences."));
@@ -830,9 +991,22 @@ geCache::geCache (QWidget *parent):
   geCacheTimer->start (500);
 
 
+  //  The build engine runs the cache builds (see buildEngine.cpp).  It tells us what's going on with signals.
+
+  buildEngine = new BuildEngine (&options, &misc, this);
+  connect (buildEngine, SIGNAL (progress (int32_t, int32_t, int64_t)), this, SLOT (slotBuildProgress (int32_t, int32_t, int64_t)));
+  connect (buildEngine, SIGNAL (cacheFull ()), this, SLOT (slotBuildCacheFull ()));
+  connect (buildEngine, SIGNAL (copyProgress (int32_t, int32_t, int64_t, int64_t)), this,
+           SLOT (slotBuildCopyProgress (int32_t, int32_t, int64_t, int64_t)));
+  connect (buildEngine, SIGNAL (segmentSaved (const QString &, const QString &)), this, SLOT (slotBuildSegmentSaved (const QString &, const QString &)));
+  connect (buildEngine, SIGNAL (finished ()), this, SLOT (slotBuildFinished ()));
+  connect (buildEngine, SIGNAL (stopped ()), this, SLOT (slotBuildStopped ()));
+  connect (buildEngine, SIGNAL (error (const QString &)), this, SLOT (slotBuildError (const QString &)));
+
+
   //  Compute the size of the cache box in meters.
 
-  computeSize (&misc, &options);
+  sizeArea ();
 
 
   //  Google Earth warning
@@ -875,7 +1049,7 @@ void geCache::slotGeCacheTabChanged (int tab)
 void geCache::slotShapeTabChanged (int tab)
 {
   options.shape_tab = tab;
-  computeSize (&misc, &options);
+  sizeArea ();
 
 
   //  If we switched tabs we may need to redraw (assuming we're linked, which will be checked in positionGoogleEarth).
@@ -1048,7 +1222,7 @@ void geCache::getClipboard ()
       for (int32_t i = 0 ; i < 8 ; i++) bBounds[i]->setChecked (false);
 
 
-      computeSize (&misc, &options);
+      sizeArea ();
     }
 
 
@@ -1070,202 +1244,160 @@ geCache::slotGeCacheTimer ()
   QString            ltstring, lnstring, geo_string, string;
 
 
-  int64_t sizeDir (const QString &source);
-  uint8_t copyDir (const QString &source, const QString &dest);
-
-
   //  I'm using this instead of the "changed" signal (since it doesn't work on Windows).  Basically, the user clicked one of the bounds buttons on the Cache
   //  tab so corner_clicked got set to 1 = NW, 2 = NE, 3 = SW, or 4 = SE.
 
   if (bounds_clicked != NO_BOUNDS) getClipboard ();
+}
 
 
-  //  If a cache build is running...
-
-  if (buildGoogleEarthProc && buildGoogleEarthProc->state () == QProcess::Running)
-    {
-      //  We want to wait 20 seconds (40 counts) after we first start Google Earth just to make sure that it has settled down.
-
-      if (!build_start_flag || misc.second_count > 40)
-        {
-          build_start_flag = false;
-
-          if ((misc.second_count / 2) >= options.cache_update_frequency)
-            {
-              misc.second_count = -1;
-
-              int64_t cache_size = sizeDir (options.ge_dir);
-              float size_num = 0;
-              QString sizeStr;
-
-
-              //  We're too close to the max cache size so we need to offer the user a chance to save cache and continue.
-
-              if (cache_size >= 2100000000)
-                {
-                  QMessageBox msgBox;
-                  msgBox.setText (tr ("The cache directory has almost reached maximum size."));
-                  msgBox.setInformativeText (tr ("Do you want to save the cache directory and continue to build or cancel the build process?"));
-                  msgBox.setStandardButtons (QMessageBox::Save | QMessageBox::Cancel);
-                  msgBox.setDefaultButton (QMessageBox::Save);
-                  int ret = msgBox.exec ();
-
-                  switch (ret)
-                    {
-                    case QMessageBox::Save:
-
-                      slotSaveCacheClicked ();
-
-                      
-                      //  Remove the Google Earth cache directory.
-
-                      QDir (options.ge_dir).removeRecursively ();
-
-
-                      //  Copy the snapshot back into the cache directory
-
-                      copyDir (cache_snapshot, options.ge_dir);
-
 
-                      //  Reset the build MBR to the west side of the current row.
+//  The build engine moved on to the next box.  Show the progress, the estimated time remaining, and the cache size.
 
-                      build_direction = 0;
-                      misc.view_area_mbr.min_x = misc.build_area_mbr.min_x;
-                      misc.view_area_mbr.max_x = misc.view_area_mbr.min_x + misc.box_size_x_deg;
+void 
+geCache::slotBuildProgress (int32_t value, int32_t remaining, int64_t cache_size)
+{
+  float size_num = 0;
+  QString sizeStr;
 
 
+  if (cache_size > 1073741824)
+    {
+      size_num = (double) cache_size / 1073741824.0;
+      sizeStr.sprintf ("%.1fG", size_num);
+    }
+  else
+    {
+      size_num = (double) cache_size / 1048576.0;
+      sizeStr.sprintf ("%.1fM", size_num);
+    }
 
-                      //  Check the box for overlap if we're doing a polygon.
 
-                      if (misc.poly_flag)
-                        {
-                          NV_F64_COORD2 mbr_poly[4];
+  progress->setValue (value);
 
-                          mbr_poly[0].x = misc.view_area_mbr.min_x;
-                          mbr_poly[0].y = misc.view_area_mbr.min_y;
-                          mbr_poly[1].x = misc.view_area_mbr.min_x;
-                          mbr_poly[1].y = misc.view_area_mbr.max_y;
-                          mbr_poly[2].x = misc.view_area_mbr.max_x;
-                          mbr_poly[2].y = misc.view_area_mbr.max_y;
-                          mbr_poly[3].x = misc.view_area_mbr.max_x;
-                          mbr_poly[3].y = misc.view_area_mbr.min_y;
 
-                          int32_t poly_size = (int32_t) options.polygon.size ();
+  int32_t hour = remaining / 3600;
+  int32_t minute = (remaining / 60) % 60;
+  int32_t second = remaining % 60;
 
-                          if (!polygon_intersection (mbr_poly, 4, options.polygon.data (), poly_size)) misc.view_flag = false;
-                        }
+  QString title = tr ("Cache build progress - Estimated time remaining - %1:%2:%3 - Cache size %4").arg (hour, 2, 10, zero).arg
+    (minute, 2, 10, zero).arg (second, 2, 10, zero).arg (sizeStr);
 
 
-                      //  Subtract the count of the boxes we've completed on this row (because we're going to do them again).
+  //  For a pyramid build let the user know which level we're on.
 
-                      iteration_count -= x_box_count;
-                      x_box_count = 0;
-                      break;
+  int32_t build_index = buildEngine->build_index;
 
+  if (misc.plan.level_box_size.size () > 1 && build_index < (int32_t) misc.plan.box.size ())
+    {
+      int32_t level = misc.plan.box[build_index].level;
 
-                    case QMessageBox::Cancel:
+      title += tr (" - Level %1 of %2 (%3 meters)").arg (level + 1).arg (misc.plan.level_box_size.size ()).arg (misc.plan.level_box_size[level]);
+    }
 
-                      killBuildGoogleEarth ();
-                      return;
-                      break;
-                    }
-                }
-              else if (cache_size > 1073741824)
-                {
-                  size_num = (double) cache_size / 1073741824.0;
-                  sizeStr.sprintf ("%.1fG", size_num);
-                }
-              else
-                {
-                  size_num = (double) cache_size / 1048576.0;
-                  sizeStr.sprintf ("%.1fM", size_num);
-                }
+  progBox->setTitle (title);
 
+  qApp->processEvents ();
+}
 
-              progress->setValue (iteration_count++);
 
 
-              boxes_remaining--;
+//  The cache directory has almost reached the maximum size so we need to offer the user a chance to save the cache and continue.
 
+void 
+geCache::slotBuildCacheFull ()
+{
+  QMessageBox msgBox;
+  msgBox.setText (tr ("The cache directory has almost reached maximum size."));
+  msgBox.setInformativeText (tr ("Do you want to save the cache directory and continue to build or cancel the build process?"));
+  msgBox.setStandardButtons (QMessageBox::Save | QMessageBox::Cancel);
+  msgBox.setDefaultButton (QMessageBox::Save);
+  int ret = msgBox.exec ();
+
+  switch (ret)
+    {
+    case QMessageBox::Save:
+      slotSaveCacheClicked ();
+      break;
 
-              int32_t remaining = (boxes_remaining + 2) * options.cache_update_frequency;
+    case QMessageBox::Cancel:
+      buildEngine->stop ();
+      break;
+    }
+}
 
 
-              //  Wait twice the update frequency with the box reset to the whole area.
 
-              if (build_kill_flag || remaining <= 0) remaining = 2 * options.cache_update_frequency;
+//  An unattended build is saving a segment.
 
+void 
+geCache::slotBuildCopyProgress (int32_t files_done, int32_t total_files, int64_t bytes_done, int64_t total_bytes)
+{
+  progBox->setTitle (tr ("Saving segment - %1 of %2 files, %3 of %4 MB").arg (files_done).arg (total_files).arg (bytes_done / 1048576).
+                     arg (total_bytes / 1048576));
+}
 
-              int32_t hour = remaining / 3600;
-              int32_t minute = (remaining / 60) % 60;
-              int32_t second = remaining % 60;
 
-              progBox->setTitle (tr ("Cache build progress - Estimated time remaining - %1:%2:%3 - Cache size %4").arg (hour, 2, 10, zero).arg (minute, 2, 10, zero).arg
-                                 (second, 2, 10, zero).arg (sizeStr));
 
-              qApp->processEvents ();
+//  Let the user know how the segment was copied (the next progress update will replace this).
 
+void 
+geCache::slotBuildSegmentSaved (const QString &segment, const QString &stats)
+{
+  progBox->setTitle (tr ("Cache saved to %1 - %2").arg (QFileInfo (segment).fileName ()).arg (stats));
+}
 
-              positionBuildGoogleEarth ();
 
 
-              //  Check for the kill flag (which will be set by positionBuildGoogleEarth when we exceed the northern bounds).
+//  The build has finished.  Offer to save the cache (an unattended build has already saved it).
 
-              if (build_kill_flag)
-                {
-                  //  This will position the view over the entire area.
+void 
+geCache::slotBuildFinished ()
+{
+  if (options.unattended_build) return;
 
-                  positionBuildGoogleEarth ();
 
+  QMessageBox msgBox;
+  msgBox.setText (tr ("The cache build has finished."));
+  msgBox.setInformativeText (tr ("Do you want to save the cache directory?"));
+  msgBox.setStandardButtons (QMessageBox::Save | QMessageBox::Cancel);
+  msgBox.setDefaultButton (QMessageBox::Save);
+  int ret = msgBox.exec ();
 
-                  if (misc.poly_flag)
-                    {
-                      progress->setValue (misc.poly_iterations - 1);
-                    }
-                  else
-                    {
-                      progress->setValue (misc.iterations - 1);
-                    }
-                  qApp->processEvents ();
+  switch (ret)
+    {
+    case QMessageBox::Save:
+      slotSaveCacheClicked ();
+      break;
 
+    case QMessageBox::Cancel:
+      break;
+    }
+}
 
-#ifdef _MSC_VER
 
-                  int32_t wait_time = remaining * 1000;
-                  Sleep (wait_time);
 
-#else
+//  The build engine has shut down Google Earth (the build finished, was stopped, or Google Earth died).
 
-                  int32_t wait_time = remaining;
-                  sleep (wait_time);
+void 
+geCache::slotBuildStopped ()
+{
+  progBox->setTitle (tr ("Cache build progress"));
 
-#endif
+  setWidgetStates ();
 
-                  killBuildGoogleEarth ();
+  progress->reset ();
 
 
-                  QMessageBox msgBox;
-                  msgBox.setText (tr ("The cache build has finished."));
-                  msgBox.setInformativeText (tr ("Do you want to save the cache directory?"));
-                  msgBox.setStandardButtons (QMessageBox::Save | QMessageBox::Cancel);
-                  msgBox.setDefaultButton (QMessageBox::Save);
-                  int ret = msgBox.exec ();
+  qApp->processEvents ();
+}
 
-                  switch (ret)
-                    {
-                    case QMessageBox::Save:
-                      slotSaveCacheClicked ();
-                      break;
 
-                    case QMessageBox::Cancel:
-                      break;
-                    }
-                }
-            }
-        }
 
-      misc.second_count++;
-    }
+void 
+geCache::slotBuildError (const QString &message)
+{
+  QMessageBox::critical (this, tr ("geCache Build cache"), message);
 }
 
 
@@ -1362,7 +1494,7 @@ geCache::slotNorthEditingFinished ()
 
   north->setText (ltstring);
 
-  computeSize (&misc, &options);
+  sizeArea ();
 
 
   //  If we're running Google Earth for preview, we're allowing changes to take effect even if we're linked (scary, nyet).
@@ -1412,7 +1544,7 @@ geCache::slotWestEditingFinished ()
 
   west->setText (lnstring);
 
-  computeSize (&misc, &options);
+  sizeArea ();
 
 
   //  If we're running Google Earth for preview, we're allowing changes to take effect even if we're linked (scary, nyet).
@@ -1462,7 +1594,7 @@ geCache::slotEastEditingFinished ()
 
   east->setText (lnstring);
 
-  computeSize (&misc, &options);
+  sizeArea ();
 
 
   //  If we're running Google Earth for preview, we're allowing changes to take effect even if we're linked (scary, nyet).
@@ -1512,7 +1644,7 @@ geCache::slotSouthEditingFinished ()
 
   south->setText (ltstring);
 
-  computeSize (&misc, &options);
+  sizeArea ();
 
 
   //  If we're running Google Earth for preview, we're allowing changes to take effect even if we're linked (scary, nyet).
@@ -1560,7 +1692,7 @@ geCache::slotClosePolyClicked ()
 
   //  Figure out how many boxes we have to scan.
 
-  computeSize (&misc, &options);
+  sizeArea ();
 }
 
 
@@ -2009,260 +2141,302 @@ UNREFERENCED_PARAMETER (checked);
 
 
 
-uint8_t 
-geCache::positionBuildGoogleEarth ()
+void 
+geCache::slotBuildCache ()
 {
-  NV_F64_XYMBR actual_mbr;
+  //  If we were previewing an area in Google Earth, kill it and start a new session for the build.
+
+  if (googleEarthProc && googleEarthProc->state () == QProcess::Running) killGoogleEarth ();
 
 
-  //  Last time through we want to show the entire area.
+  //  If the build process is running, pressing the build button again will kill the process.
 
-  if (build_kill_flag)
+  if (buildEngine->running ())
     {
-      actual_mbr = misc.build_area_mbr;
+      buildEngine->stop ();
     }
   else
     {
-      actual_mbr.min_x = misc.view_area_mbr.min_x + misc.x_border;
-      actual_mbr.max_x = misc.view_area_mbr.max_x - misc.x_border;
-      actual_mbr.min_y = misc.view_area_mbr.min_y + misc.y_border;
-      actual_mbr.max_y = misc.view_area_mbr.max_y - misc.y_border;
+      startBuild (false);
     }
 
 
-  if ((build_ge_tmp_fp[1] = fopen (build_ge_tmp_name[1], "w")) == NULL)
-    {
-      QMessageBox::critical (this, tr ("geCache Google Earth"), tr ("Unable to open temporary Google Earth KML file!"));
-      return (-1);
-    }
+  setWidgetStates ();
+}
 
 
-  fprintf (build_ge_tmp_fp[1], "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-  fprintf (build_ge_tmp_fp[1], "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n");
-  fprintf (build_ge_tmp_fp[1], "  <Document>\n");
 
+//  Resume a cache build that was interrupted (Google Earth crashed, the machine went down, or the user stopped it) from the
+//  checkpoint file.
+
+void 
+geCache::slotResumeBuild ()
+{
+  if (googleEarthProc && googleEarthProc->state () == QProcess::Running) killGoogleEarth ();
 
-  //  If we're doing a polygon build, we only want to change the file if the current box overlaps the polygon.  The flag will always be 
-  //  set to true for rectangle builds.
 
-  if (misc.view_flag)
+  if (!readCheckpoint (&options, &misc, &resume_index, &resume_box_count, &resume_coverage_start, &cache_snapshot))
     {
+      QMessageBox::warning (this, tr ("geCache Resume build"), tr ("There is no cache build to resume for %1").arg (options.ge_dir));
+      setWidgetStates ();
+      return;
+    }
 
-      //  This is the box
 
-      fprintf (build_ge_tmp_fp[1], "    <Style id=\"Transparent\">\n");
-      fprintf (build_ge_tmp_fp[1], "      <LineStyle>\n");
-      fprintf (build_ge_tmp_fp[1], "        <width>1.5</width>\n");
-      fprintf (build_ge_tmp_fp[1], "      </LineStyle>\n");
-      fprintf (build_ge_tmp_fp[1], "      <PolyStyle>\n");
-      fprintf (build_ge_tmp_fp[1], "        <color>00000000</color>\n");
+  //  Put the area and build parameters from the checkpoint back into the GUI.
 
+  double deg, min, sec;
+  char hem;
 
-      //  The last time through we want to draw the box
+  QString ltstring = qFixpos (options.cache_mbr.max_y, &deg, &min, &sec, &hem, QPOS_LAT, options.position_form);
+  north->setText (ltstring);
+  ltstring = qFixpos (options.cache_mbr.min_y, &deg, &min, &sec, &hem, QPOS_LAT, options.position_form);
+  south->setText (ltstring);
+  QString lnstring = qFixpos (options.cache_mbr.max_x, &deg, &min, &sec, &hem, QPOS_LON, options.position_form);
+  east->setText (lnstring);
+  lnstring = qFixpos (options.cache_mbr.min_x, &deg, &min, &sec, &hem, QPOS_LON, options.position_form);
+  west->setText (lnstring);
 
-      if (build_kill_flag)
-        {
-          fprintf (build_ge_tmp_fp[1], "        <outline>1</outline>\n");
-        }
-      else
-        {
-          fprintf (build_ge_tmp_fp[1], "        <outline>0</outline>\n");
-        }
+  vertices->clear ();
+
+  for (uint32_t i = 0 ; i < options.polygon.size () ; i++)
+    {
+      ltstring = qFixpos (options.polygon[i].y, &deg, &min, &sec, &hem, QPOS_LAT, options.position_form);
+      lnstring = qFixpos (options.polygon[i].x, &deg, &min, &sec, &hem, QPOS_LON, options.position_form);
+      vertices->addItem (ltstring + " " + lnstring);
+    }
 
-      fprintf (build_ge_tmp_fp[1], "        <fill>0</fill>\n");
-      fprintf (build_ge_tmp_fp[1], "      </PolyStyle>\n");
-      fprintf (build_ge_tmp_fp[1], "    </Style>\n");
-      fprintf (build_ge_tmp_fp[1], "    <Placemark>\n");
-      fprintf (build_ge_tmp_fp[1], "      <name>geCache displayed area</name>\n");
-      fprintf (build_ge_tmp_fp[1], "      <styleUrl>#Transparent</styleUrl>\n");
-      fprintf (build_ge_tmp_fp[1], "      <Polygon>\n");
-      fprintf (build_ge_tmp_fp[1], "        <extrude>1</extrude>\n");
 
+  //  Block the signals so that we don't recompute the size for every change (startBuild will do it).
 
-      //  We also want to tesselate the box on the last time through.
+  boxSize->blockSignals (true);
+  buildOrder->blockSignals (true);
+  shapeTab->blockSignals (true);
 
-      if (build_kill_flag)
-        {
-          fprintf (build_ge_tmp_fp[1], "        <tessellate>1</tessellate>\n");
-          fprintf (build_ge_tmp_fp[1], "        <altitudeMode>clampToGround</altitudeMode>\n");
-        }
-      else
-        {
-          fprintf (build_ge_tmp_fp[1], "        <altitudeMode>relativeToGround</altitudeMode>\n");
-        }
+  boxSize->setValue (options.build_box_size);
+  buildOrder->setCurrentIndex (options.build_order);
+  shapeTab->setCurrentIndex (options.shape_tab);
+  incrementalBuild->setChecked (options.incremental_build);
+  unattendedBuild->setChecked (options.unattended_build);
 
+  boxSize->blockSignals (false);
+  buildOrder->blockSignals (false);
+  shapeTab->blockSignals (false);
 
-      fprintf (build_ge_tmp_fp[1], "        <outerBoundaryIs>\n");
-      fprintf (build_ge_tmp_fp[1], "          <LinearRing>\n");
-      fprintf (build_ge_tmp_fp[1], "            <coordinates>\n");
-      fprintf (build_ge_tmp_fp[1], "              %.11f,%.11f,10\n", actual_mbr.min_x, actual_mbr.min_y);
-      fprintf (build_ge_tmp_fp[1], "              %.11f,%.11f,10\n", actual_mbr.min_x, actual_mbr.max_y);
-      fprintf (build_ge_tmp_fp[1], "              %.11f,%.11f,10\n", actual_mbr.max_x, actual_mbr.max_y);
-      fprintf (build_ge_tmp_fp[1], "              %.11f,%.11f,10\n", actual_mbr.max_x, actual_mbr.min_y);
-      fprintf (build_ge_tmp_fp[1], "              %.11f,%.11f,10\n", actual_mbr.min_x, actual_mbr.min_y);
-      fprintf (build_ge_tmp_fp[1], "            </coordinates>\n");
-      fprintf (build_ge_tmp_fp[1], "          </LinearRing>\n");
-      fprintf (build_ge_tmp_fp[1], "        </outerBoundaryIs>\n");
-      fprintf (build_ge_tmp_fp[1], "      </Polygon>\n");
-      fprintf (build_ge_tmp_fp[1], "    </Placemark>\n");
-    }
+  QStringList levels;
+  for (uint32_t i = 0 ; i < options.pyramid_levels.size () ; i++) levels += QString::number (options.pyramid_levels.at (i));
+  pyramidLevels->setText (levels.join (", "));
 
-  fprintf (build_ge_tmp_fp[1], "  </Document>\n");
-  fprintf (build_ge_tmp_fp[1], "</kml>\n");
 
-  fclose (build_ge_tmp_fp[1]);
+  startBuild (true);
 
 
-  //  If we set the kill flag the last time, just return;
+  setWidgetStates ();
+}
 
-  if (build_kill_flag) return (0);
 
 
-  do
-    {
-      switch (build_direction)
-        {
-        case 0:
+//  Start (or resume) a cache build.
 
-          //  Move right one box
+void 
+geCache::startBuild (uint8_t resume)
+{
+  //  Make sure the Google Earth cache directory is usable.
 
-          misc.view_area_mbr.min_x += misc.box_size_x_deg;
+#ifdef _MSC_VER
 
+  if (options.ge_dir.at (1) != ':' || options.ge_dir.at (2) != '\\')
+    {
+      QMessageBox::warning (this, tr ("geCache Error"), tr ("Google Earth cache folder path must be fully qualified (e.g. start with DRIVE_LETTER:\\)"));
+      return;
+    }
 
-          //  If we've passed the end of the area...
+  if (!QFile (options.ge_dir).exists ())
+    {
+      QMessageBox::warning (this, tr ("geCache Error"), tr ("Google Earth cache folder %1 does not exist!").arg (options.ge_dir));
+      return;
+    }
 
-          if (misc.view_area_mbr.max_x >= misc.build_area_mbr.max_x)
-            {
-              x_box_count = 0;
+#else
 
+  if (options.ge_dir.at (0) != '/')
+    {
+      QMessageBox::warning (this, tr ("geCache Error"), tr ("Google Earth cache directory path must be fully qualified (i.e. start with /)"));
+      return;
+    }
 
-              //  Reset min_x to the previous location.
+  if (!QFile (options.ge_dir).exists ())
+    {
+      QMessageBox::warning (this, tr ("geCache Error"), tr ("Google Earth cache directory %1 does not exist!").arg (options.ge_dir));
+      return;
+    }
 
-              misc.view_area_mbr.min_x -= misc.box_size_x_deg;
+#endif
 
 
-              //  Move up one box
+  //  When we're resuming a build we want to keep whatever Google Earth had already put in the cache directory and the area
+  //  came from the checkpoint (not from the bounds line edit boxes).
 
-              misc.view_area_mbr.min_y += misc.box_size_y_deg;
+  if (!resume)
+    {
+      //  An unattended build needs to know where to put the segments before we get started.
 
+      if (options.unattended_build && !getSegmentBase ()) return;
 
-              //  If we've passed the top of the area, we're done.
 
-              if (misc.view_area_mbr.min_y >= misc.build_area_mbr.max_y)
-                {
-                  build_kill_flag = true;
-                  misc.view_flag = true;
-                }
-              else
-                {
-                  build_direction = 1;
-                }
-            }
-          else
+      //  Never build into a mounted saved cache.  Put the real cache directory (and its coverage index) back.
+
+      if (cacheMounted (options.ge_dir))
+        {
+          if (!unmountCache (options.ge_dir))
             {
-              x_box_count++;
+              QMessageBox::warning (this, tr ("geCache Error"), tr ("Unable to unmount the saved cache from %1.").arg (options.ge_dir));
+              return;
             }
 
-          break;
+          readCoverage (options.ge_dir, &misc.coverage);
+        }
 
-        case 1:
 
-          //  Move left one box
+      //  Remove the Google Earth cache directory (and its coverage index) unless we're adding to the cache that is already there.
 
-          misc.view_area_mbr.min_x -= misc.box_size_x_deg;
+      if (!options.incremental_build)
+        {
+          removeDirLater (options.ge_dir);
 
+          clearCoverage (&misc.coverage);
+          writeCoverage (options.ge_dir, &misc.coverage);
+        }
 
-          //  If we've passed the end of the area...
 
-          if (misc.view_area_mbr.max_x <= misc.build_area_mbr.min_x)
-            {
-              x_box_count = 0;
+      //  Make sure we have values in the bounds line edit boxes and that they make sense.
+
+      if (!getBounds ()) return;
+    }
 
 
-              //  Reset min_x to the previous location.
+  //  Figure out how many iterations it will take to do the build so that we can set up a progress bar and make sure we have the
+  //  list of boxes for the build.
 
-              misc.view_area_mbr.min_x += misc.box_size_x_deg;
+  if (!sizeArea () || !setBuildPlan (&misc, &options))
+    {
+      QMessageBox::critical (this, tr ("geCache Build cache"), tr ("Unable to allocate build plan memory!"));
+      return;
+    }
 
+  int32_t build_index = 0, coverage_start = 0;
 
-              //  Move up one box
+  if (!misc.plan.box.size ())
+    {
+      QMessageBox::warning (this, tr ("geCache Build cache"), tr ("There are no areas to be cached!"));
+      return;
+    }
 
-              misc.view_area_mbr.min_y += misc.box_size_y_deg;
 
+  //  If we're resuming, make sure that we regenerated the same plan and then back up one box (the box that was being displayed
+  //  when the build died may not have finished loading).
 
-              //  If we've passed the top of the area, we're done.
+  if (resume)
+    {
+      if ((int32_t) misc.plan.box.size () != resume_box_count || resume_index > (int32_t) misc.plan.box.size ())
+        {
+          QMessageBox::warning (this, tr ("geCache Resume build"), tr ("The build plan does not match the checkpoint, the build can't be resumed!"));
+          return;
+        }
 
-              if (misc.view_area_mbr.min_y >= misc.build_area_mbr.max_y)
-                {
-                  build_kill_flag = true;
-                  misc.view_flag = true;
-                }
-              else
-                {
-                  build_direction = 0;
-                }
-            }
-          else
-            {
-              x_box_count++;
-            }
+      build_index = qMax (0, resume_index - 1);
+      coverage_start = resume_coverage_start;
+    }
 
-          break;
+  int32_t hour, minute, second;
+
+
+  //  Nobody is going to sit and watch a build that takes more than a day, so we only allow that for unattended builds (which
+  //  save the cache to segments as it fills up).
+
+  if (misc.poly_flag)
+    {
+      if (!options.unattended_build && misc.total_poly_time > 86400)
+        {
+          QMessageBox::warning (this, tr ("geCache Build cache"), tr ("The estimated time to complete the cache build is more than a day!.  Check <b>Unattended</b> to run builds this long."));
+          return;
         }
 
-      if (!build_kill_flag)
+      hour = misc.total_poly_time / 3600;
+      minute = (misc.total_poly_time / 60) % 60;
+      second = misc.total_poly_time % 60;
+
+      progress->setRange (0, misc.poly_iterations);
+    }
+  else
+    {
+      if (!options.unattended_build && misc.total_rect_time > 86400)
         {
-          misc.view_area_mbr.max_y = misc.view_area_mbr.min_y + misc.box_size_y_deg;
-          misc.view_area_mbr.max_x = misc.view_area_mbr.min_x + misc.box_size_x_deg;
+          QMessageBox::warning (this, tr ("geCache Build cache"), tr ("The estimated time to complete the cache build is more than a day!.  Check <b>Unattended</b> to run builds this long."));
+          return;
+        }
 
+      hour = misc.total_rect_time / 3600;
+      minute = (misc.total_rect_time / 60) % 60;
+      second = misc.total_rect_time % 60;
 
-          //  Check the box for overlap if we're doing a polygon.
+      progress->setRange (0, misc.iterations);
+    }
 
-          if (misc.poly_flag)
-            {
-              NV_F64_COORD2 mbr_poly[4];
+  progress->setValue (build_index);
+  progBox->setTitle (tr ("Cache build progress - Estimated time remaining - %1:%2:%3").arg (hour, 2, 10, zero).arg (minute, 2, 10, zero).arg (second, 2, 10, zero));
 
-              mbr_poly[0].x = misc.view_area_mbr.min_x;
-              mbr_poly[0].y = misc.view_area_mbr.min_y;
-              mbr_poly[1].x = misc.view_area_mbr.min_x;
-              mbr_poly[1].y = misc.view_area_mbr.max_y;
-              mbr_poly[2].x = misc.view_area_mbr.max_x;
-              mbr_poly[2].y = misc.view_area_mbr.max_y;
-              mbr_poly[3].x = misc.view_area_mbr.max_x;
-              mbr_poly[3].y = misc.view_area_mbr.min_y;
+  qApp->processEvents ();
 
-              int32_t poly_size = (int32_t) options.polygon.size ();
 
+  //  If we're not resuming, the build engine will take a new snapshot (see BuildEngine::snapshotCache).
 
-              misc.view_flag = polygon_intersection (mbr_poly, 4, options.polygon.data (), poly_size);
-            }
-        }
-    } while (!misc.view_flag);
+  if (!resume) cache_snapshot.clear ();
 
-  return (0);
+
+  qApp->setOverrideCursor (Qt::WaitCursor);
+  qApp->processEvents ();
+
+  buildEngine->start (resume, build_index, coverage_start, cache_snapshot);
+
+  qApp->restoreOverrideCursor ();
 }
 
 
 
 void 
-geCache::slotBuildCache ()
+geCache::slotSaveCacheClicked ()
 {
-  uint8_t copyDir (const QString &source, const QString &dest);
+  QFileDialog *fd = new QFileDialog (this, tr ("geCache Save cache"));
+  fd->setViewMode (QFileDialog::List);
+  fd->setOption (QFileDialog::DontUseNativeDialog, true);
+  fd->setOption (QFileDialog::ShowDirsOnly, true);
 
+  fd->setFileMode (QFileDialog::AnyFile);
 
-  //  If we were previewing an area in Google Earth, kill it and start a new session for the build.
 
-  if (googleEarthProc && googleEarthProc->state () == QProcess::Running) killGoogleEarth ();
+  //  If the last used directory still exists, set the directory.
 
+  if (QDir (options.stash_dir).exists ()) fd->setDirectory (QDir (options.stash_dir).absolutePath ());
 
-  //  If the build process is running, pressing the build button again will kill the process.
 
-  if (buildGoogleEarthProc && buildGoogleEarthProc->state () == QProcess::Running)
-    {
-      killBuildGoogleEarth ();
-    }
-  else
+  if (fd->exec () == QDialog::Accepted) 
     {
-      //  Remove the Google Earth cache directory.
+      QStringList files = fd->selectedFiles ();
+
+      QString file = files.at (0);
+
+      if (file.isEmpty ())
+        {
+          QMessageBox::warning (this, tr ("geCache Save cache"), tr ("You must select an existing directory or enter a name for a new directory."));
+          return;
+        }
+
+
+      QString save_dir = file;
+
+
+      //  Copy the Google Earth cache directory.
 
 #ifdef _MSC_VER
 
@@ -2294,351 +2468,301 @@ geCache::slotBuildCache ()
 
 #endif
 
-      QDir (options.ge_dir).removeRecursively ();
-
-
-      //  Make sure we have values in the bounds line edit boxes and that they make sense.
-
-      if (north->text ().isEmpty () || south->text ().isEmpty () || west->text ().isEmpty () || east->text ().isEmpty ())
-        {
-          QMessageBox::warning (this, tr ("geCache Area bounds"), tr ("You must set all four area fields."));
-          return;
-        }
-
+      //  Save the directory that we were in when we selected a directory.
 
-      double tmp;
+      options.stash_dir = fd->directory ().absolutePath ();
 
-      qPosfix (north->text (), &options.cache_mbr.max_y, QPOS_LAT);
-      qPosfix (south->text (), &options.cache_mbr.min_y, QPOS_LAT);
-      qPosfix (east->text (), &options.cache_mbr.max_x, QPOS_LON);
-      qPosfix (west->text (), &options.cache_mbr.min_x, QPOS_LON);
 
-      if (options.cache_mbr.max_y < options.cache_mbr.min_y)
-        {
-          tmp = options.cache_mbr.min_y;
-          options.cache_mbr.min_y = options.cache_mbr.max_y;
-          options.cache_mbr.max_y = tmp;
-        }
+      saveCache (save_dir);
+    }
+}
 
-      if (options.cache_mbr.max_x < options.cache_mbr.min_x)
-        {
-          if ((options.cache_mbr.max_x < 0.0 && options.cache_mbr.min_x < 0.0) || (options.cache_mbr.max_x >= 0.0 && options.cache_mbr.min_x >= 0.0))
-            {
-              tmp = options.cache_mbr.min_x;
-              options.cache_mbr.min_x = options.cache_mbr.max_x;
-              options.cache_mbr.max_x = tmp;
-            }
-        }
 
 
-      QString arg;
-      QStringList arguments;
+//  Gets the area bounds from the bounds line edit boxes.  Returns false (after telling the user) if any of them are empty.
 
-      arguments.clear ();
+uint8_t 
+geCache::getBounds ()
+{
+  if (north->text ().isEmpty () || south->text ().isEmpty () || west->text ().isEmpty () || east->text ().isEmpty ())
+    {
+      QMessageBox::warning (this, tr ("geCache Area bounds"), tr ("You must set all four area fields."));
+      return (false);
+    }
 
 
-      QString tmp0 = QDir::tempPath () + SEPARATOR + QString ("geCache_GE_%1_tmp_build_link.kml").arg (misc.process_id);
-      QString tmp1 = QDir::tempPath () + SEPARATOR + QString ("geCache_GE_%1_tmp_build_look.kml").arg (misc.process_id);
+  double tmp;
 
-      strcpy (build_ge_tmp_name[0], tmp0.toLatin1 ());
-      strcpy (build_ge_tmp_name[1], tmp1.toLatin1 ());
+  qPosfix (north->text (), &options.cache_mbr.max_y, QPOS_LAT);
+  qPosfix (south->text (), &options.cache_mbr.min_y, QPOS_LAT);
+  qPosfix (east->text (), &options.cache_mbr.max_x, QPOS_LON);
+  qPosfix (west->text (), &options.cache_mbr.min_x, QPOS_LON);
 
+  if (options.cache_mbr.max_y < options.cache_mbr.min_y)
+    {
+      tmp = options.cache_mbr.min_y;
+      options.cache_mbr.min_y = options.cache_mbr.max_y;
+      options.cache_mbr.max_y = tmp;
+    }
 
-      if ((build_ge_tmp_fp[0] = fopen (build_ge_tmp_name[0], "w")) == NULL)
+  if (options.cache_mbr.max_x < options.cache_mbr.min_x)
+    {
+      if ((options.cache_mbr.max_x < 0.0 && options.cache_mbr.min_x < 0.0) || (options.cache_mbr.max_x >= 0.0 && options.cache_mbr.min_x >= 0.0))
         {
-          QMessageBox::critical (this, tr ("geCache Google Earth"), tr ("Unable to open temporary Google Earth link file!"));
-          return;
+          tmp = options.cache_mbr.min_x;
+          options.cache_mbr.min_x = options.cache_mbr.max_x;
+          options.cache_mbr.max_x = tmp;
         }
+    }
 
+  return (true);
+}
 
-      //  Get the full path names.
 
-      QString geFile = QFileInfo (QString (build_ge_tmp_name[0])).absoluteFilePath ();
-      QString geFile2 = QFileInfo (QString (build_ge_tmp_name[1])).absoluteFilePath ();
 
+//  Computes the size of the area, the number of boxes, and the estimated build time (see computeSize) and puts them in the area
+//  info labels.  Returns false if computeSize ran out of memory.
 
-      //  Put the full names back into the character strings.
+uint8_t 
+geCache::sizeArea ()
+{
+  if (!computeSize (&misc, &options)) return (false);
 
-      strcpy (build_ge_tmp_name[0], geFile.toLatin1 ());
-      strcpy (build_ge_tmp_name[1], geFile2.toLatin1 ());
 
+  meterWidth->setText (tr ("Width = %1 meters").arg (misc.area_width, 0, 'f', 1));
+  meterHeight->setText (tr ("Height = %1 meters").arg (misc.area_height, 0, 'f', 1));
 
-      //  Figure out how many iterations it will take to do the build so that we can set up a progress bar.
+  int32_t hour = misc.total_rect_time / 3600;
+  int32_t minute = (misc.total_rect_time / 60) % 60;
+  int32_t second = misc.total_rect_time % 60;
 
-      computeSize (&misc, &options);
-      iteration_count = 0;
+  rectEstTime->setText (tr ("Estimated time to build = %1:%2:%3").arg (hour, 2, 10, zero).arg (minute, 2, 10, zero).arg (second, 2, 10, zero));
 
-      int32_t hour, minute, second;
+  if (misc.poly_flag)
+    {
+      hour = misc.total_poly_time / 3600;
+      minute = (misc.total_poly_time / 60) % 60;
+      second = misc.total_poly_time % 60;
 
-      if (misc.poly_flag)
-        {
-          if (misc.total_poly_time > 86400)
-            {
-              QMessageBox::warning (this, tr ("geCache Build cache"), tr ("The estimated time to complete the cache build is more than a day!."));
-              return;
-            }
+      polyEstTime->setText (tr ("Estimated time to build = %1:%2:%3").arg (hour, 2, 10, zero).arg (minute, 2, 10, zero).arg (second, 2, 10, zero));
+      numBoxes->setText (tr ("Number of areas = %1").arg (misc.poly_iterations));
+    }
 
-          hour = misc.total_poly_time / 3600;
-          minute = (misc.total_poly_time / 60) % 60;
-          second = misc.total_poly_time % 60;
+  return (true);
+}
 
-          progress->setRange (0, misc.poly_iterations);
-          boxes_remaining = misc.poly_iterations;
-        }
-      else
-        {
-          if (misc.total_rect_time > 86400)
-            {
-              QMessageBox::warning (this, tr ("geCache Build cache"), tr ("The estimated time to complete the cache build is more than a day!."));
-              return;
-            }
 
-          hour = misc.total_rect_time / 3600;
-          minute = (misc.total_rect_time / 60) % 60;
-          second = misc.total_rect_time % 60;
 
-          progress->setRange (0, misc.iterations);
-          boxes_remaining = misc.iterations;
-        }
+/*!
+  Asks for the base name of the segment directories for an unattended build.  This is the only question an unattended build asks
+  and it's asked when the build is started (while somebody is still there to answer it).  Returns false if the user cancels.
+*/
+
+uint8_t 
+geCache::getSegmentBase ()
+{
+  QFileDialog *fd = new QFileDialog (this, tr ("geCache Unattended build segment name"));
+  fd->setViewMode (QFileDialog::List);
+  fd->setOption (QFileDialog::DontUseNativeDialog, true);
+  fd->setOption (QFileDialog::ShowDirsOnly, true);
 
-      progBox->setTitle (tr ("Cache build progress - Estimated time remaining - %1:%2:%3").arg (hour, 2, 10, zero).arg (minute, 2, 10, zero).arg (second, 2, 10, zero));
+  fd->setFileMode (QFileDialog::AnyFile);
 
-      qApp->processEvents ();
+  if (QDir (options.stash_dir).exists ()) fd->setDirectory (QDir (options.stash_dir).absolutePath ());
 
 
-      //  Build the "look at" file.
+  if (fd->exec () != QDialog::Accepted || fd->selectedFiles ().isEmpty () || fd->selectedFiles ().at (0).isEmpty ()) return (false);
 
-      if (positionBuildGoogleEarth ())
-        {
-          fclose (build_ge_tmp_fp[0]);
-          remove (build_ge_tmp_name[0]);
-          return;
-        }
 
+  options.stash_dir = fd->directory ().absolutePath ();
 
-      fprintf (build_ge_tmp_fp[0], "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-      fprintf (build_ge_tmp_fp[0], "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n");
-      fprintf (build_ge_tmp_fp[0], "  <NetworkLink>\n");
-      fprintf (build_ge_tmp_fp[0], "    <name>NetworkLink</name>\n");
-      fprintf (build_ge_tmp_fp[0], "    <flyToView>1</flyToView>\n");
-      fprintf (build_ge_tmp_fp[0], "    <Link>\n");
-      fprintf (build_ge_tmp_fp[0], "      <href>%s</href>\n", build_ge_tmp_name[1]);
-      fprintf (build_ge_tmp_fp[0], "      <refreshMode>onInterval</refreshMode>\n");
-      fprintf (build_ge_tmp_fp[0], "      <refreshInterval>%d</refreshInterval>\n", options.cache_update_frequency);
-      fprintf (build_ge_tmp_fp[0], "    </Link>\n");
-      fprintf (build_ge_tmp_fp[0], "  </NetworkLink>\n");
-      fprintf (build_ge_tmp_fp[0], "</kml>\n");
+  misc.segment_base = fd->selectedFiles ().at (0);
+  misc.segment_number = 1;
 
-      fclose (build_ge_tmp_fp[0]);
 
+  //  Start a new manifest.
 
-      arguments << geFile;
+  QFile (misc.segment_base + "_geCache_segments.txt").remove ();
 
+  return (true);
+}
 
-      buildGoogleEarthProc = new QProcess (this);
 
-      connect (buildGoogleEarthProc, SIGNAL (error (QProcess::ProcessError)), this, SLOT (slotBuildGoogleEarthError (QProcess::ProcessError)));
-      connect (buildGoogleEarthProc, SIGNAL (finished (int, QProcess::ExitStatus)), this, SLOT (slotBuildGoogleEarthDone (int, QProcess::ExitStatus)));
 
+/*!
+  Adds the current area, box size, and cache update frequency to the build job queue (see jobQueue.cpp) along with the base
+  name for the saved cache segments.  The queue is run with geCache --run-queue (see batchBuild.cpp).
+*/
 
-      buildGoogleEarthProc->start (options.ge_name, arguments);
+void 
+geCache::slotQueueBuild ()
+{
+  if (!getBounds ()) return;
 
-      qApp->setOverrideCursor (Qt::WaitCursor);
-      qApp->processEvents ();
 
-      buildGoogleEarthProc->waitForStarted ();
+  QFileDialog *fd = new QFileDialog (this, tr ("geCache Queue build segment name"));
+  fd->setViewMode (QFileDialog::List);
+  fd->setOption (QFileDialog::DontUseNativeDialog, true);
+  fd->setOption (QFileDialog::ShowDirsOnly, true);
 
-      qApp->restoreOverrideCursor ();
+  fd->setFileMode (QFileDialog::AnyFile);
 
-      misc.second_count = 0;
-      build_start_flag = true;
+  if (QDir (options.stash_dir).exists ()) fd->setDirectory (QDir (options.stash_dir).absolutePath ());
 
 
-      //  We need a snapshot of the newly created cache directory in case we max out the current one.  We'll pause here for a few seconds to
-      //  make sure Google Earth has started nicely, then we'll copy the cache directory.
+  if (fd->exec () != QDialog::Accepted || fd->selectedFiles ().isEmpty () || fd->selectedFiles ().at (0).isEmpty ()) return;
 
-#ifdef _MSC_VER
 
-      Sleep (3000);
+  options.stash_dir = fd->directory ().absolutePath ();
 
-#else
+  QString out_dir = fd->selectedFiles ().at (0);
 
-      sleep (3);
 
-#endif
- 
-      QDir cache_parent = QFileInfo (options.ge_dir).absoluteDir ();
+  BUILD_JOB job;
 
-      cache_snapshot = cache_parent.absolutePath () + SEPARATOR + "cache_snapshot";
+  makeJob (&options, QFileInfo (out_dir).fileName (), out_dir, &job);
 
-      if (QDir (cache_snapshot).exists ()) QDir (cache_snapshot).removeRecursively ();
+  std::vector<BUILD_JOB> jobs;
 
-      copyDir (options.ge_dir, cache_snapshot);
+  if (!addJob (&job) || !readJobQueue (&jobs))
+    {
+      QMessageBox::warning (this, tr ("geCache Queue build"), tr ("Unable to lock the job queue %1").arg (jobQueueName ()));
+      return;
     }
 
+  int32_t pending = 0;
+  for (uint32_t i = 0 ; i < jobs.size () ; i++) if (jobs[i].status != JOB_DONE) pending++;
 
-  setWidgetStates ();
+  progBox->setTitle (tr ("%1 queued - %2 jobs waiting for geCache --run-queue").arg (job.name).arg (pending));
 }
 
 
 
-//  This kills the Google Earth process and removes the temporary KML file.
+/*!
+  Copies a cache directory with a CopyEngine while showing the progress in a dialog.  If link_files is set the files that Google
+  Earth never rewrites are hard linked (see snapshotDir).  The build is paused while we wait since the dialog keeps processing
+  events and we may have been called from the build timer (when the cache fills up).
+  Returns false if the copy failed (after telling the user) or was canceled.  Either way, the partial copy has been removed.
+*/
 
-void 
-geCache::killBuildGoogleEarth ()
+uint8_t 
+geCache::copyCache (const QString &source, const QString &dest, COPY_STATS *stats, uint8_t link_files)
 {
-#ifdef _MSC_VER
+  CopyEngine engine (source, dest, options.copy_bandwidth_limit, link_files);
 
-  //  On Windows, Google Earth is a normal application so we can use the normal "kill" to get rid of it.
 
-  if (buildGoogleEarthProc->state () == QProcess::Running)
+  if (!engine.start ())
     {
-      disconnect (buildGoogleEarthProc, SIGNAL (error (QProcess::ProcessError)), this, SLOT (slotBuildGoogleEarthError (QProcess::ProcessError)));
-      disconnect (buildGoogleEarthProc, SIGNAL (finished (int, QProcess::ExitStatus)), this, SLOT (slotBuildGoogleEarthDone (int, QProcess::ExitStatus)));
-
-      buildGoogleEarthProc->kill ();
+      QMessageBox::warning (this, tr ("geCache Error"), tr ("Unable to copy %1 to %2").arg (source).arg (dest));
+      return (false);
     }
 
 
-#else
+  uint8_t building = buildEngine->running ();
+  if (building) buildEngine->pause (true);
 
+  QString label = tr ("Copying %1 to %2").arg (QFileInfo (source).fileName ()).arg (QFileInfo (dest).fileName ());
 
-  //  On Linux, Google Earth is run from a script so we can't use the normal "kill" technique because all we'll kill that way will be the script.
-  //  That leaves Google Earth still running.  What we need to do on Linux is to find the Google Earth script that belongs to the current user,
-  //  find its child, and kill that.
+  QProgressDialog dialog (label, tr ("Cancel"), 0, 1000, this);
+  dialog.setWindowTitle (tr ("geCache"));
+  dialog.setWindowModality (Qt::WindowModal);
+  dialog.setMinimumDuration (500);
 
-  if (buildGoogleEarthProc->state () == QProcess::Running)
+  while (!engine.wait (100))
     {
-      disconnect (buildGoogleEarthProc, SIGNAL (error (QProcess::ProcessError)), this, SLOT (slotBuildGoogleEarthError (QProcess::ProcessError)));
-      disconnect (buildGoogleEarthProc, SIGNAL (finished (int, QProcess::ExitStatus)), this, SLOT (slotBuildGoogleEarthDone (int, QProcess::ExitStatus)));
-
-      Q_PID pid = buildGoogleEarthProc->pid ();
-      QProcess killer;
-      QStringList params;
-      params << "--ppid";
-      params << QString::number (pid);
-      params << "-o";
-      params << "pid";
-      params << "--noheaders";
-      killer.start ("/bin/ps", params, QIODevice::ReadOnly);
-
-      if (killer.waitForStarted (-1))
-        { 
-          if (killer.waitForFinished (-1))
-            {
-              QByteArray temp = killer.readAllStandardOutput ();
-              QString str = QString::fromLocal8Bit (temp);
-              QStringList list = str.split ("\n");
-
-              for (int32_t i = 0 ; i < list.size () ; i++)
-                {
-                  if (!list.at (i).isEmpty ()) kill (list.at (i).toInt (), SIGKILL);
-                }
-            }
-        }
+      int32_t permille = engine.total_bytes ? (int32_t) (engine.bytes_done.load () * 1000 / engine.total_bytes) : 0;
 
+      dialog.setLabelText (label + "\n" + tr ("%1 of %2 files, %3 of %4 MB").arg (engine.files_done.load ()).arg (engine.total_files).
+                           arg (engine.bytes_done.load () / 1048576).arg (engine.total_bytes / 1048576));
+      dialog.setValue (permille);
 
-      //  Now kill the script (this probably isn't necessary).
+      qApp->processEvents ();
 
-      buildGoogleEarthProc->kill ();
+      if (dialog.wasCanceled ()) engine.cancel ();
     }
 
-#endif
+  dialog.reset ();
 
-  delete (buildGoogleEarthProc);
+  if (building) buildEngine->pause (false);
 
-  buildGoogleEarthProc = NULL;
 
-  build_direction = 0;
-  build_kill_flag = false;
+  *stats = engine.stats;
 
-  progBox->setTitle (tr ("Cache build progress"));
-
-  setWidgetStates ();
+  if (engine.succeeded ()) return (true);
 
-  progress->reset ();
+  if (!engine.canceled ()) QMessageBox::warning (this, tr ("geCache Error"), tr ("Unable to copy %1 to %2").arg (source).arg (dest));
 
-
-  qApp->processEvents ();
+  return (false);
+}
 
 
-  remove (build_ge_tmp_name[0]);
-  remove (build_ge_tmp_name[1]);
 
+/*!
+  Copies the Google Earth cache directory to save_dir along with its coverage index (see coverage.cpp) and an area file
+  (save_dir_geCache.kml) containing the rectangle or polygon (see writeAreaFile).  This is used by the Save cache button and when
+  the cache fills up during an attended build.
+*/
 
-  //  Get rid of the cache snapshot directory
+uint8_t 
+geCache::saveCache (const QString &save_dir)
+{
+  removeDirLater (save_dir);
 
-  if (QDir (cache_snapshot).exists ()) QDir (cache_snapshot).removeRecursively ();
-}
 
+  COPY_STATS stats;
 
+  if (!copyCache (options.ge_dir, save_dir, &stats))
+    {
+      progBox->setTitle (tr ("Cache not saved"));
+      return (false);
+    }
 
-//!  Error callback from the build Google Earth process.
 
-void 
-geCache::slotBuildGoogleEarthError (QProcess::ProcessError error)
-{
-  switch (error)
-    {
-    case QProcess::FailedToStart:
-      QMessageBox::critical (this, tr ("geCache Google Earth"), tr ("Unable to start Google Earth!"));
-      break;
+  qApp->setOverrideCursor (Qt::WaitCursor);
+  qApp->processEvents ();
 
-    case QProcess::Crashed:
-      QMessageBox::critical (this, tr ("geCache Google Earth"), tr ("Google Earth crashed!"));
-      break;
 
-    case QProcess::Timedout:
-      QMessageBox::critical (this, tr ("geCache Google Earth"), tr ("Google Earth timed out!"));
-      break;
+  //  Let the user know how the copy was done (the build timer will replace this on the next box if we're building).
 
-    case QProcess::WriteError:
-      QMessageBox::critical (this, tr ("geCache Google Earth"), tr ("There was a write error in Google Earth!"));
-      break;
+  progBox->setTitle (tr ("Cache saved to %1 - %2").arg (QFileInfo (save_dir).fileName ()).arg (copyStatsText (&stats)));
 
-    case QProcess::ReadError:
-      QMessageBox::critical (this, tr ("geCache Google Earth"), tr ("There was a read error in Google Earth!"));
-      break;
 
-    case QProcess::UnknownError:
-      QMessageBox::critical (this, tr ("geCache Google Earth"), tr ("Google Earth died with an unknown error!"));
-      break;
-    }
+  //  Save the coverage index with the cache.  If we're in the middle of a build, the boxes that have been visited so far
+  //  are in the cache too.
 
+  COVERAGE_INDEX saved_coverage = misc.coverage;
 
-  if (buildGoogleEarthProc) killBuildGoogleEarth ();
-}
+  if (buildEngine->running () && !addCoverage (&saved_coverage, &misc.plan, buildEngine->coverage_start, buildEngine->build_index))
+    QMessageBox::warning (this, tr ("geCache Error"), tr ("Unable to allocate coverage index memory!  The coverage index for %1 is incomplete.").arg (save_dir));
 
+  writeCoverage (save_dir, &saved_coverage);
 
 
-void 
-geCache::slotBuildGoogleEarthDone (int exitCode ATTR_UNUSED, QProcess::ExitStatus exitStatus ATTR_UNUSED)
-{
-#ifdef _MSC_VER
-UNREFERENCED_PARAMETER (exitCode);
-UNREFERENCED_PARAMETER (exitStatus);
-#endif
+  //  Save the rectangle or polygon to the area file.
 
+  if (!writeAreaFile (save_dir, &options))
+    {
+      qApp->restoreOverrideCursor ();
+      QMessageBox::warning (this, tr ("geCache Error"), tr ("Cannot open area file %1").arg (save_dir));
+      return (false);
+    }
 
-  //  It's already dead but killBuildGoogleEarth will clean up all details (as Don Henley would say).
+  qApp->restoreOverrideCursor ();
 
-  if (buildGoogleEarthProc) killBuildGoogleEarth ();
+  return (true);
 }
 
 
 
 void 
-geCache::slotSaveCacheClicked ()
+geCache::slotLoadCacheClicked ()
 {
-  uint8_t copyDir (const QString &source, const QString &dest);
-
-
-  QFileDialog *fd = new QFileDialog (this, tr ("geCache Save cache"));
+  QFileDialog *fd = new QFileDialog (this, tr ("geCache Load cache"));
   fd->setViewMode (QFileDialog::List);
   fd->setOption (QFileDialog::DontUseNativeDialog, true);
   fd->setOption (QFileDialog::ShowDirsOnly, true);
 
-  fd->setFileMode (QFileDialog::AnyFile);
+  fd->setFileMode (QFileDialog::Directory);
 
 
   //  If the last used directory still exists, set the directory.
@@ -2646,25 +2770,60 @@ geCache::slotSaveCacheClicked ()
   if (QDir (options.stash_dir).exists ()) fd->setDirectory (QDir (options.stash_dir).absolutePath ());
 
 
-  if (fd->exec () == QDialog::Accepted) 
+  if (fd->exec () == QDialog::Accepted)
     {
       QStringList files = fd->selectedFiles ();
 
       QString file = files.at (0);
 
-      if (file.isEmpty ())
+
+      if (file.isEmpty ()) file = fd->directory ().absolutePath ();
+
+
+      //  Save the parent directory of the selected directory as the stash directory.
+
+      options.stash_dir = QFileInfo (file).dir ().absolutePath ();
+
+
+      QString load_dir = file;
+
+
+      //  Since version 1.03 geCache writes a kml area file that is associated with the saved cache directory.  If one is there, we need to 
+      //  read it and get the rectangle or polygon from the area file.
+
+      if (readAreaFile (load_dir + "_geCache.kml", &options))
         {
-          QMessageBox::warning (this, tr ("geCache Save cache"), tr ("You must select an existing directory or enter a name for a new directory."));
-          return;
-        }
+          double deg, min, sec;
+          char hem;
 
+          QString ltstring = qFixpos (options.cache_mbr.max_y, &deg, &min, &sec, &hem, QPOS_LAT, options.position_form);
+          north->setText (ltstring);
+          ltstring = qFixpos (options.cache_mbr.min_y, &deg, &min, &sec, &hem, QPOS_LAT, options.position_form);
+          south->setText (ltstring);
+          QString lnstring = qFixpos (options.cache_mbr.max_x, &deg, &min, &sec, &hem, QPOS_LON, options.position_form);
+          east->setText (lnstring);
+          lnstring = qFixpos (options.cache_mbr.min_x, &deg, &min, &sec, &hem, QPOS_LON, options.position_form);
+          west->setText (lnstring);
 
-      QString save_dir = file;
 
-      if (QDir (save_dir).exists ()) QDir (save_dir).removeRecursively ();
+          vertices->clear ();
 
 
-      //  Copy the Google Earth cache directory.
+          //  Populate the polygon vertices if any were saved and restored.
+
+          for (uint32_t i = 0 ; i < options.polygon.size () ; i++)
+            {
+              ltstring = qFixpos (options.polygon[i].y, &deg, &min, &sec, &hem, QPOS_LAT, options.position_form);
+              lnstring = qFixpos (options.polygon[i].x, &deg, &min, &sec, &hem, QPOS_LON, options.position_form);
+              vertices->addItem (ltstring + " " + lnstring);
+            }
+
+
+          shapeTab->setCurrentIndex (options.shape_tab);
+        }
+
+
+      //  Check the Google Earth cache directory.
 
 #ifdef _MSC_VER
 
@@ -2696,319 +2855,225 @@ geCache::slotSaveCacheClicked ()
 
 #endif
 
-      //  Save the directory that we were in when we selected a directory.
-
-      options.stash_dir = fd->directory ().absolutePath ();
-
-
-      qApp->setOverrideCursor (Qt::WaitCursor);
-      qApp->processEvents ();
-
-      copyDir (options.ge_dir, save_dir);
-
-
-      //  Save the rectangle or polygon to the kml file.
 
-      QString areaName = QFileInfo (file).baseName ();
-      char area_name[256];
-      strcpy (area_name, areaName.toLatin1 ());
+      //  If we're mounting saved caches, point the Google Earth cache directory at the saved cache.  If we're protecting it, we
+      //  point it at a stage next to the saved cache instead (see stageCache).
 
-      FILE *fp;
-      char fname[1024];
-      strcpy (fname, file.append ("_geCache.kml").toLatin1 ());
-
-      if ((fp = fopen (fname, "w")) == NULL)
-        {
-          QMessageBox::warning (this, tr ("geCache Error"), tr ("Cannot open area file %1").arg (file));
-          return;
-        }
-
-      fprintf (fp, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-      fprintf (fp, "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n");
-      fprintf (fp, "  <Document>\n");
-      fprintf (fp, "    <Style id=\"Transparent\">\n");
-      fprintf (fp, "      <LineStyle>\n");
-      fprintf (fp, "        <width>3</width>\n");
-      fprintf (fp, "      </LineStyle>\n");
-      fprintf (fp, "      <PolyStyle>\n");
-      fprintf (fp, "        <color>00000000</color>\n");
-      fprintf (fp, "        <outline>1</outline>\n");
-      fprintf (fp, "        <fill>0</fill>\n");
-      fprintf (fp, "      </PolyStyle>\n");
-      fprintf (fp, "    </Style>\n");
-
-
-      if (options.shape_tab == POLY_TAB && options.polygon.size ())
+      if (options.mount_cache)
         {
-          fprintf (fp, "    <Placemark>\n");
-          fprintf (fp, "      <name>%s (polygon)</name>\n", area_name);
-          fprintf (fp, "      <styleUrl>#Transparent</styleUrl>\n");
+          QString target_dir = load_dir;
 
-          fprintf (fp, "      <Polygon>\n");
-          fprintf (fp, "        <tessellate>1</tessellate>\n");
-          fprintf (fp, "        <altitudeMode>clampToGround</altitudeMode>\n");
-          fprintf (fp, "        <outerBoundaryIs>\n");
-          fprintf (fp, "          <LinearRing>\n");
-          fprintf (fp, "            <coordinates>\n");
+          COPY_STATS stats;
 
-          for (uint32_t i = 0 ; i < options.polygon.size () ; i++)
+          if (options.mount_protect)
             {
-              //  Make sure we haven't created any duplicate points
+              target_dir = mountStageName (load_dir);
 
-              if (i && options.polygon[i].x == options.polygon[i - 1].x && options.polygon[i].y == options.polygon[i - 1].y) continue;
+              removeDirLater (target_dir);
 
-              fprintf (fp, "              %.11f,%.11f,10\n", options.polygon[i].x, options.polygon[i].y);
+              if (!stageCache (load_dir, target_dir, &stats))
+                {
+                  progBox->setTitle (tr ("Cache not mounted"));
+                  QMessageBox::warning (this, tr ("geCache Error"), tr ("Unable to stage %1 in %2.").arg (load_dir).arg (target_dir));
+                  return;
+                }
             }
 
-          fprintf (fp, "              %.11f,%.11f,10\n", options.polygon[0].x, options.polygon[0].y);
-          fprintf (fp, "            </coordinates>\n");
-          fprintf (fp, "          </LinearRing>\n");
-          fprintf (fp, "        </outerBoundaryIs>\n");
-          fprintf (fp, "      </Polygon>\n");
-          fprintf (fp, "    </Placemark>\n");
+          if (!mountCache (target_dir, options.ge_dir))
+            {
+              if (options.mount_protect) removeDirLater (target_dir);
+              progBox->setTitle (tr ("Cache not mounted"));
+              QMessageBox::warning (this, tr ("geCache Error"), tr ("Unable to mount %1 on the Google Earth cache directory %2.").arg (load_dir).arg (options.ge_dir));
+              return;
+            }
+
+          if (options.mount_protect)
+            {
+              progBox->setTitle (tr ("Cache mounted from %1 - %2").arg (QFileInfo (load_dir).fileName ()).arg (copyStatsText (&stats)));
+            }
+          else
+            {
+              QString size = QString::number ((double) sizeDir (load_dir) / 1048576.0, 'f', 1);
+              progBox->setTitle (tr ("Cache mounted from %1 (%2M)").arg (QFileInfo (load_dir).fileName ()).arg (size));
+            }
         }
       else
         {
-          fprintf (fp, "    <Placemark>\n");
-          fprintf (fp, "      <name>%s (rectangle)</name>\n", area_name);
-          fprintf (fp, "      <styleUrl>#Transparent</styleUrl>\n");
-          fprintf (fp, "      <Polygon>\n");
-          fprintf (fp, "        <extrude>1</extrude>\n");
-          fprintf (fp, "        <tessellate>1</tessellate>\n");
-          fprintf (fp, "        <altitudeMode>clampToGround</altitudeMode>\n");
-          fprintf (fp, "        <outerBoundaryIs>\n");
-          fprintf (fp, "          <LinearRing>\n");
-          fprintf (fp, "            <coordinates>\n");
-          fprintf (fp, "              %.11f,%.11f,10\n", options.cache_mbr.min_x, options.cache_mbr.min_y);
-          fprintf (fp, "              %.11f,%.11f,10\n", options.cache_mbr.min_x, options.cache_mbr.max_y);
-          fprintf (fp, "              %.11f,%.11f,10\n", options.cache_mbr.max_x, options.cache_mbr.max_y);
-          fprintf (fp, "              %.11f,%.11f,10\n", options.cache_mbr.max_x, options.cache_mbr.min_y);
-          fprintf (fp, "              %.11f,%.11f,10\n", options.cache_mbr.min_x, options.cache_mbr.min_y);
-          fprintf (fp, "            </coordinates>\n");
-          fprintf (fp, "          </LinearRing>\n");
-          fprintf (fp, "        </outerBoundaryIs>\n");
-          fprintf (fp, "      </Polygon>\n");
-          fprintf (fp, "    </Placemark>\n");
-        }
-
-      fprintf (fp, "  </Document>\n");
-      fprintf (fp, "</kml>\n");
-
-      fclose (fp);
-
-      qApp->restoreOverrideCursor ();
-    }
-}
-
+          //  Put the real cache directory back if a saved cache is mounted on it.
 
+          if (!unmountCache (options.ge_dir))
+            {
+              progBox->setTitle (tr ("Cache not loaded"));
+              QMessageBox::warning (this, tr ("geCache Error"), tr ("Unable to unmount the saved cache from %1.").arg (options.ge_dir));
+              return;
+            }
 
-void 
-geCache::slotLoadCacheClicked ()
-{
-  uint8_t copyDir (const QString &source, const QString &dest);
 
+          //  Stage the loaded cache next to the Google Earth cache directory (hard linking the files that Google Earth never
+          //  rewrites) and then swap it in.  The old cache isn't touched until the new one is completely there and it's removed
+          //  in the background afterwards.
 
-  QFileDialog *fd = new QFileDialog (this, tr ("geCache Load cache"));
-  fd->setViewMode (QFileDialog::List);
-  fd->setOption (QFileDialog::DontUseNativeDialog, true);
-  fd->setOption (QFileDialog::ShowDirsOnly, true);
+          QString stage_dir = options.ge_dir + "_geCache_load";
 
-  fd->setFileMode (QFileDialog::Directory);
+          removeDirLater (stage_dir);
 
 
-  //  If the last used directory still exists, set the directory.
+          COPY_STATS stats;
 
-  if (QDir (options.stash_dir).exists ()) fd->setDirectory (QDir (options.stash_dir).absolutePath ());
+          if (!copyCache (load_dir, stage_dir, &stats, true))
+            {
+              progBox->setTitle (tr ("Cache not loaded"));
+              return;
+            }
 
+          QString old_dir = tombstoneName (options.ge_dir);
 
-  if (fd->exec () == QDialog::Accepted)
-    {
-      QStringList files = fd->selectedFiles ();
+          if (!swapDir (stage_dir, options.ge_dir, old_dir))
+            {
+              removeDirLater (stage_dir);
+              progBox->setTitle (tr ("Cache not loaded"));
+              QMessageBox::warning (this, tr ("geCache Error"), tr ("Unable to replace the Google Earth cache directory %1.  It may be in use.").arg (options.ge_dir));
+              return;
+            }
 
-      QString file = files.at (0);
+          removeDirLater (old_dir);
 
+          progBox->setTitle (tr ("Cache loaded from %1 - %2").arg (QFileInfo (load_dir).fileName ()).arg (copyStatsText (&stats)));
+        }
 
-      if (file.isEmpty ()) file = fd->directory ().absolutePath ();
 
+      qApp->setOverrideCursor (Qt::WaitCursor);
+      qApp->processEvents ();
 
-      //  Save the parent directory of the selected directory as the stash directory.
 
-      options.stash_dir = QFileInfo (file).dir ().absolutePath ();
+      //  The loaded cache's coverage index (if it has one) is now the coverage index for the Google Earth cache directory.
 
+      readCoverage (load_dir, &misc.coverage);
+      writeCoverage (options.ge_dir, &misc.coverage);
 
-      QString load_dir = file;
+      sizeArea ();
 
+      qApp->restoreOverrideCursor ();
+    }
+}
 
-      //  Since version 1.03 geCache writes a kml area file that is associated with the saved cache directory.  If one is there, we need to 
-      //  read it and get the rectangle or polygon from the area file.
 
-      FILE *fp;
-      char fname[1024], str[128];
-      strcpy (fname, file.append ("_geCache.kml").toLatin1 ());
-      uint8_t rect_flag = false, start_coords = 0;
 
-      if ((fp = fopen (fname, "r")) != NULL)
-        {
-          options.polygon.clear ();
-          while (fgets (str, sizeof (str), fp) != NULL)
-            {
-              QString strng = QString (str);
+//  Change the cache box size.
 
+void 
+geCache::slotBoxSizeChanged (int value)
+{
+  options.build_box_size = value;
 
-              //  First look for the name to see if it is a polygon (default) or a rectangle.
+  sizeArea ();
+}
 
-              if (strng.contains ("<name>"))
-                {
-                  if (strng.contains ("rectangle")) rect_flag = true;
-                }
-              else if (strng.contains ("<coordinates>"))
-                {
-                  start_coords = 1;
-                }
-              else if (strng.contains ("</coordinates>"))
-                {
-                  break;
-                }
-              else if (start_coords)
-                {
-                  double lat_degs, lon_degs;
-                  float elev;
 
-                  sscanf (str, "%lf,%lf,%f", &lon_degs, &lat_degs, &elev);
 
-                  NV_F64_COORD2 pnt = {lon_degs, lat_degs};
-                  options.polygon.push_back (pnt);
-                }
-            }
+//  Change the cache update frequency.
 
-          fclose (fp);
+void 
+geCache::slotCacheUpdateChanged (int value)
+{
+  options.cache_update_frequency = value;
 
+  sizeArea ();
+}
 
-          options.cache_mbr.min_y = 99999999999.0;
-          options.cache_mbr.min_x = 99999999999.0;
-          options.cache_mbr.max_y = -99999999999.0;
-          options.cache_mbr.max_x = -99999999999.0;
-    
-          for (uint32_t i = 0 ; i < options.polygon.size () ; i++)
-            {
-              if (options.polygon[i].y < options.cache_mbr.min_y) options.cache_mbr.min_y = options.polygon[i].y;
-              if (options.polygon[i].y > options.cache_mbr.max_y) options.cache_mbr.max_y = options.polygon[i].y;
-              if (options.polygon[i].x < options.cache_mbr.min_x) options.cache_mbr.min_x = options.polygon[i].x;
-              if (options.polygon[i].x > options.cache_mbr.max_x) options.cache_mbr.max_x = options.polygon[i].x;
-            }
 
 
-          double deg, min, sec;
-          char hem;
+//  Turn adaptive dwell on or off.
 
-          QString ltstring = qFixpos (options.cache_mbr.max_y, &deg, &min, &sec, &hem, QPOS_LAT, options.position_form);
-          north->setText (ltstring);
-          ltstring = qFixpos (options.cache_mbr.min_y, &deg, &min, &sec, &hem, QPOS_LAT, options.position_form);
-          south->setText (ltstring);
-          QString lnstring = qFixpos (options.cache_mbr.max_x, &deg, &min, &sec, &hem, QPOS_LON, options.position_form);
-          east->setText (lnstring);
-          lnstring = qFixpos (options.cache_mbr.min_x, &deg, &min, &sec, &hem, QPOS_LON, options.position_form);
-          west->setText (lnstring);
+void 
+geCache::slotAdaptiveDwellClicked (bool checked)
+{
+  options.adaptive_dwell = checked;
+}
 
 
-          vertices->clear ();
 
+//  Change the minimum dwell time for adaptive dwell.
 
-          if (rect_flag)
-            {
-              options.polygon.clear ();
-              options.shape_tab = RECT_TAB;
-            }
-          else
-            {
-              //  Populate the polygon vertices if any were saved and restored.
+void 
+geCache::slotDwellMinChanged (int value)
+{
+  options.dwell_min = value;
+}
 
-              for (uint32_t i = 0 ; i < options.polygon.size () ; i++)
-                {
-                  ltstring = qFixpos (options.polygon[i].y, &deg, &min, &sec, &hem, QPOS_LAT, options.position_form);
-                  lnstring = qFixpos (options.polygon[i].x, &deg, &min, &sec, &hem, QPOS_LON, options.position_form);
-                  vertices->addItem (ltstring + " " + lnstring);
-                }
 
-              options.shape_tab = POLY_TAB;
-            }
 
+//  Change the settle time for adaptive dwell.
 
-          shapeTab->setCurrentIndex (options.shape_tab);
-        }
+void 
+geCache::slotDwellSettleChanged (int value)
+{
+  options.dwell_settle = value;
+}
 
 
-      //  Remove the Google Earth cache directory.
 
-#ifdef _MSC_VER
+//  Change the cache build order.
 
-      if (options.ge_dir.at (1) != ':' || options.ge_dir.at (2) != '\\')
-        {
-          QMessageBox::warning (this, tr ("geCache Error"), tr ("Google Earth cache folder path must be fully qualified (e.g. start with DRIVE_LETTER:\\)"));
-          return;
-        }
+void 
+geCache::slotBuildOrderChanged (int index)
+{
+  options.build_order = index;
 
-      if (!QFile (options.ge_dir).exists ())
-        {
-          QMessageBox::warning (this, tr ("geCache Error"), tr ("Google Earth cache folder %1 does not exist!").arg (options.ge_dir));
-          return;
-        }
+  sizeArea ();
+}
 
-#else
 
-      if (options.ge_dir.at (0) != '/')
-        {
-          QMessageBox::warning (this, tr ("geCache Error"), tr ("Google Earth cache directory path must be fully qualified (i.e. start with /)"));
-          return;
-        }
 
-      if (!QFile (options.ge_dir).exists ())
-        {
-          QMessageBox::warning (this, tr ("geCache Error"), tr ("Google Earth cache directory %1 does not exist!").arg (options.ge_dir));
-          return;
-        }
+//  Turn incremental builds on or off.
 
-#endif
+void 
+geCache::slotIncrementalBuildClicked (bool checked)
+{
+  options.incremental_build = checked;
 
-      QDir (options.ge_dir).removeRecursively ();
+  sizeArea ();
+}
 
 
-      qApp->setOverrideCursor (Qt::WaitCursor);
-      qApp->processEvents ();
 
-      if (!copyDir (load_dir, options.ge_dir))
-        {
-          QMessageBox::warning (this, tr ("geCache Error"), tr ("Can't copy loaded cache directory to cache!"));
-          qApp->restoreOverrideCursor ();
-          return;
-        }
+//  Turn unattended builds on or off.
 
-      qApp->restoreOverrideCursor ();
-    }
+void 
+geCache::slotUnattendedBuildClicked (bool checked)
+{
+  options.unattended_build = checked;
 }
 
 
 
-//  Change the cache box size.
+//  Change the pyramid build area sizes.  We only keep sizes that are in the same range as the initial area size (plus a bit
+//  more since these are the coarse levels) and then put the cleaned up list back in the text field.
 
 void 
-geCache::slotBoxSizeChanged (int value)
+geCache::slotPyramidLevelsEditingFinished ()
 {
-  options.build_box_size = value;
+  QStringList fields = pyramidLevels->text ().split (QRegExp ("[,\\s]+"), QString::SkipEmptyParts);
 
-  computeSize (&misc, &options);
-}
+  options.pyramid_levels.clear ();
 
+  for (int32_t i = 0 ; i < fields.size () ; i++)
+    {
+      bool ok;
+      int32_t value = fields.at (i).toInt (&ok);
 
+      if (ok && value >= 500 && value <= 500000) options.pyramid_levels.push_back (value);
+    }
 
-//  Change the cache update frequency.
+  std::sort (options.pyramid_levels.begin (), options.pyramid_levels.end (), std::greater<int32_t> ());
+  options.pyramid_levels.erase (std::unique (options.pyramid_levels.begin (), options.pyramid_levels.end ()), options.pyramid_levels.end ());
 
-void 
-geCache::slotCacheUpdateChanged (int value)
-{
-  options.cache_update_frequency = value;
 
-  computeSize (&misc, &options);
+  QStringList levels;
+  for (uint32_t i = 0 ; i < options.pyramid_levels.size () ; i++) levels += QString::number (options.pyramid_levels.at (i));
+  pyramidLevels->setText (levels.join (", "));
+
+  sizeArea ();
 }
 
 
@@ -3132,11 +3197,50 @@ geCache::slotCacheBrowseClicked ()
       options.ge_dir = file;
 
       geCacheDir->setText (options.ge_dir);
+
+
+      readCoverage (options.ge_dir, &misc.coverage);
+
+      sizeArea ();
     }
 }
 
 
 
+void
+geCache::slotCacheLimitChanged (int value)
+{
+  options.cache_size_limit = value;
+}
+
+
+
+void
+geCache::slotCopyLimitChanged (int value)
+{
+  options.copy_bandwidth_limit = value;
+}
+
+
+
+void
+geCache::slotMountCacheClicked (bool checked)
+{
+  options.mount_cache = checked;
+
+  mountProtectCheck->setEnabled (checked);
+}
+
+
+
+void
+geCache::slotMountProtectClicked (bool checked)
+{
+  options.mount_protect = checked;
+}
+
+
+
 void
 geCache::slotIconSizeChanged (int index)
 {
@@ -3199,7 +3303,7 @@ geCache::slotQuit ()
   //  Check to see if Google Earth is running.  This will also get rid of the temporary KML files.
 
   if (googleEarthProc) killGoogleEarth ();
-  if (buildGoogleEarthProc) killBuildGoogleEarth ();
+  if (buildEngine->running ()) buildEngine->stop ();
 
 
   //  Use frame geometry to get the absolute x and y.
@@ -3270,7 +3374,13 @@ geCache::setWidgetStates ()
       bClearPoly->setEnabled (false);
       boxSize->setEnabled (false);
       cacheUpdate->setEnabled (false);
+      adaptiveBox->setEnabled (false);
+      buildOrder->setEnabled (false);
+      pyramidLevels->setEnabled (false);
+      incrementalBuild->setEnabled (false);
+      unattendedBuild->setEnabled (false);
       bBuildCache->setEnabled (false);
+      bResumeBuild->setEnabled (false);
       bSaveCache->setEnabled (false);
       bLoadCache->setEnabled (false);
       bGoogleEarthLink->setEnabled (false);
@@ -3289,7 +3399,13 @@ geCache::setWidgetStates ()
       bClearPoly->setToolTip (bstring);
       boxSize->setToolTip (bstring);
       cacheUpdate->setToolTip (fstring);
+      adaptiveBox->setToolTip (fstring);
+      buildOrder->setToolTip (fstring);
+      pyramidLevels->setToolTip (fstring);
+      incrementalBuild->setToolTip (fstring);
+      unattendedBuild->setToolTip (fstring);
       bBuildCache->setToolTip (bstring);
+      bResumeBuild->setToolTip (bstring);
       bSaveCache->setToolTip (bstring);
       bLoadCache->setToolTip (bstring);
       bGoogleEarthLink->setToolTip (bstring);
@@ -3302,7 +3418,7 @@ geCache::setWidgetStates ()
     {
       //  We're running Google Earth to build cache...
 
-      if (buildGoogleEarthProc)
+      if (buildEngine->running ())
         {
           geCacheTab->setTabEnabled (PREF_TAB, false);
           bGoogleEarth->setEnabled (false);
@@ -3317,6 +3433,12 @@ geCache::setWidgetStates ()
           bClearPoly->setEnabled (false);
           boxSize->setEnabled (false);
           cacheUpdate->setEnabled (false);
+          adaptiveBox->setEnabled (false);
+          buildOrder->setEnabled (false);
+          pyramidLevels->setEnabled (false);
+          incrementalBuild->setEnabled (false);
+          unattendedBuild->setEnabled (false);
+          bResumeBuild->setEnabled (false);
           bSaveCache->setEnabled (false);
           bLoadCache->setEnabled (false);
 
@@ -3339,6 +3461,12 @@ geCache::setWidgetStates ()
           boxSize->setToolTip (bstring);
           boxSize->setToolTip (fstring);
           cacheUpdate->setToolTip (fstring);
+          adaptiveBox->setToolTip (fstring);
+          buildOrder->setToolTip (fstring);
+          pyramidLevels->setToolTip (fstring);
+          incrementalBuild->setToolTip (fstring);
+          unattendedBuild->setToolTip (fstring);
+          bResumeBuild->setToolTip (bstring);
           bSaveCache->setToolTip (bstring);
           bLoadCache->setToolTip (bstring);
         }
@@ -3358,6 +3486,7 @@ geCache::setWidgetStates ()
               bGoogleEarth->setEnabled (true);
               bGoogleEarthLink->setEnabled (true);
               bBuildCache->setEnabled (true);
+              bResumeBuild->setEnabled (QFileInfo (checkpointName (misc.batch_run)).exists ());
 
               bSaveCache->setEnabled (false);
               bLoadCache->setEnabled (false);
@@ -3406,11 +3535,21 @@ geCache::setWidgetStates ()
 
                   boxSize->setEnabled (false);
                   cacheUpdate->setEnabled (false);
+                  adaptiveBox->setEnabled (false);
+                  buildOrder->setEnabled (false);
+                  pyramidLevels->setEnabled (false);
+                  incrementalBuild->setEnabled (false);
+                  unattendedBuild->setEnabled (false);
 
                   fstring = tr ("This field is disabled because Google Earth is running to preview an area and it is linked to geCache");
 
                   boxSize->setToolTip (fstring);
                   cacheUpdate->setToolTip (fstring);
+                  adaptiveBox->setToolTip (fstring);
+                  buildOrder->setToolTip (fstring);
+                  pyramidLevels->setToolTip (fstring);
+                  incrementalBuild->setToolTip (fstring);
+                  unattendedBuild->setToolTip (fstring);
                 }
 
 
@@ -3420,6 +3559,11 @@ geCache::setWidgetStates ()
                 {
                   boxSize->setEnabled (true);
                   cacheUpdate->setEnabled (true);
+                  adaptiveBox->setEnabled (true);
+                  buildOrder->setEnabled (true);
+                  pyramidLevels->setEnabled (true);
+                  incrementalBuild->setEnabled (true);
+                  unattendedBuild->setEnabled (true);
 
                   bPoly->setEnabled (false);
 
@@ -3458,10 +3602,16 @@ geCache::setWidgetStates ()
               bGoogleEarthLink->setEnabled (false);
               for (int32_t i = 0 ; i < 8 ; i++) bBounds[i]->setEnabled (true);
               bBuildCache->setEnabled (true);
+              bResumeBuild->setEnabled (QFileInfo (checkpointName (misc.batch_run)).exists ());
               bSaveCache->setEnabled (true);
               bLoadCache->setEnabled (true);
               boxSize->setEnabled (true);
               cacheUpdate->setEnabled (true);
+              adaptiveBox->setEnabled (true);
+              buildOrder->setEnabled (true);
+              pyramidLevels->setEnabled (true);
+              incrementalBuild->setEnabled (true);
+              unattendedBuild->setEnabled (true);
               north->setEnabled (true);
               west->setEnabled (true);
               east->setEnabled (true);
@@ -3628,6 +3778,11 @@ geCache::setWidgetStates ()
     }
 
 
+  //  Builds can be added to the job queue whenever a build could be started.
+
+  bQueueBuild->setEnabled (misc.googleearth_available && !buildEngine->running () && !poly_define && !poly_edit);
+
+
   if (poly_define || poly_edit)
     {
       bc = fontString + warningTextColorString + QString ("background-color:rgba(%1,%2,%3,%4)").arg (options.warning_color.red ()).arg
@@ -3649,7 +3804,7 @@ geCache::setWidgetStates ()
 
   if (bBuildCache->isEnabled ())
     {
-      if (buildGoogleEarthProc && buildGoogleEarthProc->state () == QProcess::Running)
+      if (buildEngine->running ())
         {
           QString bc = fontString + warningTextColorString + QString ("background-color:rgba(%1,%2,%3,%4)").arg (options.warning_color.red ()).arg
             (options.warning_color.green ()).arg (options.warning_color.blue ()).arg (options.warning_color.alpha ());
@@ -3674,7 +3829,23 @@ geCache::setWidgetStates ()
   bSaveCache->setToolTip (tr ("Build Google Earth cache"));
   if (bSaveCache->isEnabled ()) bSaveCache->setToolTip (tr ("Save Google Earth cache"));
   if (bLoadCache->isEnabled ()) bLoadCache->setToolTip (tr ("Load Google Earth cache"));
+
+  if (bQueueBuild->isEnabled ()) bQueueBuild->setToolTip (tr ("Add the area and build options to the build job queue"));
+
+  if (bResumeBuild->isEnabled ())
+    {
+      bResumeBuild->setToolTip (tr ("Resume the interrupted Google Earth cache build"));
+    }
+  else if (misc.googleearth_available && !buildEngine->running ())
+    {
+      bResumeBuild->setToolTip (tr ("This button is disabled because there is no interrupted cache build to resume"));
+    }
   if (cacheUpdate->isEnabled ()) cacheUpdate->setToolTip (tr ("Change the frequency (in seconds) for the cache build process"));
+  if (adaptiveBox->isEnabled ()) adaptiveBox->setToolTip (tr ("Move to the next area as soon as Google Earth stops writing to the cache (minimum and settle time in seconds)"));
+  if (buildOrder->isEnabled ()) buildOrder->setToolTip (tr ("Change the order in which the areas are visited during the cache build process"));
+  if (pyramidLevels->isEnabled ()) pyramidLevels->setToolTip (tr ("Coarser area sizes (in meters, separated by commas) to be cached before the initial area size"));
+  if (incrementalBuild->isEnabled ()) incrementalBuild->setToolTip (tr ("Only cache the areas that aren't already in the Google Earth cache"));
+  if (unattendedBuild->isEnabled ()) unattendedBuild->setToolTip (tr ("Save the cache to numbered segment directories without asking when it fills up"));
 
   bc = fontString + warningTextColorString + QString ("background-color:rgba(%1,%2,%3,%4)").arg (options.warning_color.red ()).arg
     (options.warning_color.green ()).arg (options.warning_color.blue ()).arg (options.warning_color.alpha ());
@@ -29,17 +29,9 @@
 #ifndef _GECACHE_HPP_
 #define _GECACHE_HPP_
 
-#include <cmath>
-#include <cerrno>
+#include "geCacheEngine.hpp"
 
-#include "geCacheDef.hpp"
-#include "version.hpp"
-
-
-using namespace std;
-
-
-void computeSize (MISC *misc, OPTIONS *options);
+#include <QtWidgets>
 
 
 class geCache:public QMainWindow
@@ -56,11 +48,13 @@ public:
 
 protected:
 
-  char            ge_tmp_name[2][1024], build_ge_tmp_name[2][1024];
+  char            ge_tmp_name[2][1024];
 
-  FILE            *ge_tmp_fp[2], *build_ge_tmp_fp[2];
+  FILE            *ge_tmp_fp[2];
 
-  QProcess        *googleEarthProc, *buildGoogleEarthProc;
+  QProcess        *googleEarthProc;
+
+  BuildEngine     *buildEngine;
 
   OPTIONS         options;
 
@@ -76,43 +70,47 @@ protected:
 
   QAction         *bHelp;
 
-  QLineEdit       *north, *south, *east, *west, *geName;
+  QLineEdit       *north, *south, *east, *west, *geName, *pyramidLevels;
 
   QToolBar        *toolBar;
 
   QPushButton     *bGoogleEarth, *bGoogleEarthLink;
 
-  QPushButton     *bBounds[8], *bPoly, *bClosePoly, *bClearPoly, *bBuildCache, *bSaveCache, *bLoadCache, *bCacheBrowse, *bWarningColor, *bFont;
+  QPushButton     *bBounds[8], *bPoly, *bClosePoly, *bClearPoly, *bBuildCache, *bResumeBuild, *bQueueBuild, *bSaveCache, *bLoadCache, *bCacheBrowse, *bWarningColor, *bFont;
 
   QColor          buttonBackgroundColor, buttonTextColor;
 
   QString         normalTextColorString, warningTextColorString, fontString, prev_clipboard_text, cache_snapshot;
 
-  QSpinBox        *boxSize, *cacheUpdate;
+  QSpinBox        *boxSize, *cacheUpdate, *dwellMin, *dwellSettle, *cacheLimit, *copyLimit;
+
+  QComboBox       *iconSize, *buildOrder;
 
-  QComboBox       *iconSize;
+  QCheckBox       *incrementalBuild, *unattendedBuild, *mountCacheCheck, *mountProtectCheck;
 
-  QLabel          *geCacheDir;
+  QLabel          *geCacheDir, *meterWidth, *meterHeight, *rectEstTime, *numBoxes, *polyEstTime;
 
   QButtonGroup    *bGrp, *boundsGroup;
 
-  QGroupBox       *progBox, *cacheBarBox;
+  QGroupBox       *progBox, *cacheBarBox, *adaptiveBox;
 
   QProgressBar    *progress;
 
-  uint8_t         build_direction, build_kill_flag, build_start_flag, restart_msg, already_gone, poly_define, poly_edit;
-
-  int32_t         bounds_clicked, x_box_count, boxes_remaining, iteration_count, poly_edit_index;
+  uint8_t         restart_msg, already_gone, poly_define, poly_edit;
 
-  int64_t         start_timestamp, current_timestamp;
+  int32_t         bounds_clicked, poly_edit_index, resume_index, resume_box_count, resume_coverage_start;
 
 
   void getClipboard ();
   void setWidgetStates ();
   void killGoogleEarth ();
   uint8_t positionGoogleEarth ();
-  void killBuildGoogleEarth ();
-  uint8_t positionBuildGoogleEarth ();
+  void startBuild (uint8_t resume);
+  uint8_t getBounds ();
+  uint8_t sizeArea ();
+  uint8_t getSegmentBase ();
+  uint8_t saveCache (const QString &save_dir);
+  uint8_t copyCache (const QString &source, const QString &dest, COPY_STATS *stats, uint8_t link_files = false);
   void closeEvent (QCloseEvent *event);
 
 
@@ -137,15 +135,31 @@ protected slots:
   void slotGoogleEarthDone (int exitCode, QProcess::ExitStatus exitStatus);
   void slotGoogleEarthLink (bool checked);
 
-  void slotBuildGoogleEarthError (QProcess::ProcessError error);
-  void slotBuildGoogleEarthDone (int exitCode, QProcess::ExitStatus exitStatus);
+  void slotBuildProgress (int32_t value, int32_t remaining, int64_t cache_size);
+  void slotBuildCacheFull ();
+  void slotBuildCopyProgress (int32_t files_done, int32_t total_files, int64_t bytes_done, int64_t total_bytes);
+  void slotBuildSegmentSaved (const QString &segment, const QString &stats);
+  void slotBuildFinished ();
+  void slotBuildStopped ();
+  void slotBuildError (const QString &message);
   void slotBuildCache ();
+  void slotResumeBuild ();
+  void slotQueueBuild ();
+  void slotIncrementalBuildClicked (bool checked);
+  void slotUnattendedBuildClicked (bool checked);
 
   void slotSaveCacheClicked ();
   void slotLoadCacheClicked ();
+  void slotMountCacheClicked (bool checked);
+  void slotMountProtectClicked (bool checked);
 
   void slotBoxSizeChanged (int value);
   void slotCacheUpdateChanged (int value);
+  void slotAdaptiveDwellClicked (bool checked);
+  void slotDwellMinChanged (int value);
+  void slotDwellSettleChanged (int value);
+  void slotBuildOrderChanged (int index);
+  void slotPyramidLevelsEditingFinished ();
 
   void slotPositionClicked (int id);
   void slotWarningColor ();
@@ -155,6 +169,8 @@ protected slots:
 
   void slotFont ();
   void slotIconSizeChanged (int index);
+  void slotCacheLimitChanged (int value);
+  void slotCopyLimitChanged (int value);
 
   void slotHelp ();
   void slotQuit ();
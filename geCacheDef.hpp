@@ -47,7 +47,6 @@
 
 #include <QtCore>
 #include <QtGui>
-#include <QtWidgets>
 
 
 using namespace std;
@@ -70,6 +69,47 @@ using namespace std;
 #define EAST_BOUNDS    6
 #define SOUTH_BOUNDS   7
 
+#define BUILD_ORDER_SERPENTINE  0
+#define BUILD_ORDER_HILBERT     1
+#define BUILD_ORDER_NEAREST     2
+
+#define BUILD_DONE              0
+#define BUILD_STARTING          1
+#define BUILD_SETTLING          2
+#define BUILD_VISITING          3
+#define BUILD_FINAL_OVERVIEW    4
+#define BUILD_DRAINING          5
+#define BUILD_SAVING            6
+
+#define GE_START_MIN            3000            //  Milliseconds to wait for a pause in cache writes before the snapshot
+#define GE_START_TIMEOUT        10000           //  Maximum milliseconds to wait for Google Earth to start writing to the cache
+#define GE_READY_TIMEOUT        60000           //  Maximum milliseconds to wait for Google Earth to be ready for the first box
+
+#define BATCH_RUNNING           -1              //  Exit codes for a batch build (see batchBuild.cpp)
+#define BATCH_OK                0               //  The build finished and every segment was saved
+#define BATCH_USAGE             1               //  Bad command line
+#define BATCH_SETUP             2               //  Bad area file, cache directory, or save directory
+#define BATCH_GOOGLE_EARTH      3               //  Google Earth couldn't be started or died during the build
+#define BATCH_SAVE              4               //  A segment couldn't be saved (the build was stopped) or something else failed
+#define BATCH_INTERRUPTED       5               //  Killed with SIGINT or SIGTERM
+
+#define JOB_PENDING             0               //  Job queue entry status (see jobQueue.cpp)
+#define JOB_RUNNING             1
+#define JOB_DONE                2
+#define JOB_FAILED              3
+#define JOB_LOCK_WAIT           10000           //  Milliseconds to wait for the job queue lock file
+
+#define CACHE_GROWTH_BOXES      10
+
+#define COVERAGE_SLIVER         0.0000001       //  Uncovered strips thinner than this (in degrees) are ignored (see boxCovered)
+
+#define COPY_QFILE              0
+#define COPY_REFLINK            1
+#define COPY_FILE_RANGE         2
+#define COPY_HARDLINK           3
+#define COPY_STRATEGIES         4
+#define COPY_SKIPPED            -2              //  copyFileNative return when the source file is gone
+
 
 //  The OPTIONS structure contains all those variables that can be saved to the users geCache QSettings.
 
@@ -80,8 +120,19 @@ typedef struct
   QString           stash_dir;                  //  Last directory used to save or load a cache directory
   NV_F64_XYMBR      cache_mbr;                  //  Minimum bounding rectangle for the cache preview or build
   int32_t           build_box_size;             //  The cache build initial area size
-  int32_t           cache_update_frequency;     //  Update frequency in seconds for cache building
+  int32_t           cache_update_frequency;     //  Update frequency in seconds for cache building (maximum dwell time for adaptive dwell)
+  uint8_t           adaptive_dwell;             //  Move to the next box as soon as Google Earth stops writing to the cache directory
+  int32_t           dwell_min;                  //  Minimum time (in seconds) to stay on a box with adaptive dwell
+  int32_t           dwell_settle;               //  Time (in seconds) with no writes to the cache directory before moving on with adaptive dwell
+  std::vector<int32_t> pyramid_levels;          //  Coarser box sizes (in meters) to be visited before build_box_size for a pyramid build
+  uint8_t           incremental_build;          //  Keep the current cache and only visit the boxes that it doesn't already cover
+  uint8_t           unattended_build;           //  Save full caches to numbered segment directories without asking
+  int32_t           build_order;                //  Order in which the build boxes are visited (BUILD_ORDER_SERPENTINE, etc.)
   int32_t           icon_size;                  //  Button icon size in pixels
+  int32_t           cache_size_limit;           //  Size (in megabytes) at which the cache has to be saved and restored from the snapshot
+  int32_t           copy_bandwidth_limit;       //  Maximum rate (in megabytes per second) for saving and loading caches (0 for no limit)
+  uint8_t           mount_cache;                //  Load saved caches by linking the Google Earth cache directory to them (not on Windows)
+  uint8_t           mount_protect;              //  Mount a stage with copies of the files Google Earth rewrites instead of the saved cache
   QString           ge_name;                    //  Name of the Google Earth executable or script
   QString           ge_dir;                     //  Path to the GoogleEarth folder (Windows) or path to the .googleearth/Cache directory (Linux)
   QColor            warning_color;              //  Color used for buttons that have active running processes associated with them (e.g. Build cache)
@@ -95,6 +146,136 @@ typedef struct
 } OPTIONS;
 
 
+//  A single box (sub-area) that will be displayed in Google Earth during a cache build.
+
+typedef struct
+{
+  NV_F64_XYMBR      mbr;                        //  Box MBR (without the borders)
+  int32_t           row;                        //  Grid row of the box (0 is the southernmost row)
+  int32_t           col;                        //  Grid column of the box (0 is the westernmost column)
+  int32_t           level;                      //  Pyramid level of the box (0 is the coarsest level)
+  int32_t           restart;                    //  Index (in the plan) of the box to go back to after the cache has been saved
+  double            x_border;                   //  Amount (in degrees) to shrink the box on the east and west sides when it is displayed
+  double            y_border;                   //  Amount (in degrees) to shrink the box on the north and south sides when it is displayed
+} BUILD_BOX;
+
+
+//  The build plan.  This is generated once per area/box size (in setBuildPlan) and then used for the estimate, the progress bar,
+//  the build timer, and for backing up after the cache has been saved.  Only the boxes that will actually be displayed are
+//  in the box vector and they are stored in the order in which they will be visited (all of the boxes of a pyramid level are
+//  visited before any box of the next level).  The grid information is for the finest level.  The area MBR, level box sizes,
+//  polygon, build order, and coverage serial number are the inputs that the plan was built from.  makeBuildPlan doesn't rebuild
+//  the plan if none of them have changed.
+
+typedef struct
+{
+  NV_F64_XYMBR      area_mbr;                   //  MBR of the entire build area
+  int32_t           rows;                       //  Number of rows in the box grid
+  int32_t           cols;                       //  Maximum number of columns in any row of the box grid
+  double            box_size_y_deg;             //  Box height in decimal degrees of latitude
+  std::vector<double> box_size_x_deg;           //  Box width in decimal degrees of longitude for each row (computed at the row's latitude)
+  std::vector<int32_t> row_cols;                //  Number of columns in each row
+  std::vector<int32_t> level_box_size;          //  Box size (in meters) for each level of the build, coarsest first
+  std::vector<BUILD_BOX> box;                   //  Boxes to be visited, in build order
+  uint8_t           valid;                      //  Set if the plan has been built
+  std::vector<NV_F64_COORD2> polygon;           //  Polygon the plan was built for (empty for a rectangle)
+  int32_t           build_order;                //  Build order the plan was built for
+  int32_t           coverage_serial;            //  Serial number of the coverage index the plan was built for (-1 if not incremental)
+} BUILD_PLAN;
+
+
+//  A box that has already been cached (see coverage.cpp).
+
+typedef struct
+{
+  NV_F64_XYMBR      mbr;                        //  Box MBR
+  int32_t           box_size;                   //  Box size (in meters) that was used to cache the box
+} COVERAGE_BOX;
+
+
+//  The coverage index for a Google Earth cache.  The grid is only used to speed up lookups and is rebuilt whenever boxes have
+//  been added (dirty is set).  The serial number is incremented every time the list of boxes changes so that a build plan that
+//  was made from an older version of the index can be recognized.
+
+typedef struct
+{
+  std::vector<COVERAGE_BOX> box;                //  Every box that has been cached
+  uint8_t           dirty;                      //  Set if the grid needs to be rebuilt
+  int32_t           serial;                     //  Incremented whenever boxes are added or the index is cleared
+  NV_F64_XYMBR      mbr;                        //  MBR of all of the boxes
+  double            cell_x;                     //  Grid cell width in degrees
+  double            cell_y;                     //  Grid cell height in degrees
+  int32_t           rows;                       //  Number of rows in the grid
+  int32_t           cols;                       //  Number of columns in the grid
+  std::vector<int32_t> bucket_start;            //  Index into bucket_box of the first box for each grid cell (rows * cols + 1 entries)
+  std::vector<int32_t> bucket_box;              //  Indices of the boxes that overlap each grid cell
+} COVERAGE_INDEX;
+
+
+//  The size of every file in each directory of a tree, keyed on the directory path and then the file name (see sizeDirs).
+
+typedef QHash<QString, QHash<QString, int64_t> > DIR_FILES;
+
+
+//  The cache size tracker (see cacheSize.cpp).  The size of every file in the cache is kept so that only the files that the cache
+//  watcher says have changed need to be stat'ed again.  A changed directory is only read to find the files that were added or
+//  removed.
+
+typedef struct
+{
+  QString           cache_dir;                  //  Cache directory being tracked
+  DIR_FILES         dir_files;                  //  Size of each file in each directory of the cache
+  QSet<QString>     dirty_dirs;                 //  Directories that have had files added or removed since they were read
+  QSet<QString>     dirty_files;                //  Files that have changed since they were stat'ed
+  QSet<QString>     growing;                    //  New files that are stat'ed every time until their size stops changing
+  int64_t           total;                      //  Total size of the cache directory
+  uint8_t           sized;                      //  Set once the first full scan since resetCacheSize is in
+  int64_t           scan_timestamp;             //  Time (milliseconds since the epoch) of the last full scan
+  std::vector<int64_t> box_history;             //  Cache size after each of the last CACHE_GROWTH_BOXES boxes
+} CACHE_SIZE;
+
+
+//  How the files were copied by copyDir or snapshotDir (indexed by COPY_QFILE, COPY_REFLINK, COPY_FILE_RANGE, or COPY_HARDLINK).
+
+typedef struct
+{
+  int32_t           files[COPY_STRATEGIES];     //  Number of files copied with each strategy
+  int64_t           bytes[COPY_STRATEGIES];     //  Number of bytes copied with each strategy
+  int32_t           skipped;                    //  Number of files that were deleted (e.g. by leveldb compaction) before we got to them
+} COPY_STATS;
+
+
+//  Google Earth startup readiness (see googleEarthReady.cpp).
+
+typedef struct
+{
+  int32_t           inotify_fd;                 //  inotify descriptor watching the network link KML file for reads (-1 if none)
+  uint8_t           kml_read;                   //  Set once Google Earth has read the network link KML file
+  int64_t           kml_atime;                  //  Access time (milliseconds since the epoch) of the KML file when we started
+  int64_t           cpu_ticks;                  //  CPU time (in clock ticks) of Google Earth at the last check (-1 if not checked)
+  int64_t           cpu_timestamp;              //  Time (milliseconds since the epoch) of the last CPU check
+  int32_t           idle_checks;                //  Number of consecutive checks with Google Earth idle
+} GE_READY;
+
+
+//  An entry in the build job queue (see jobQueue.cpp).  The area is stored with the job (not just the name of the area file) so
+//  that the job can still be run if the area file has been moved.
+
+typedef struct
+{
+  QString           id;                         //  Unique id used to find the job when its status changes
+  QString           name;                       //  Area file name (or "rectangle") to identify the job
+  int32_t           shape_tab;                  //  RECT_TAB or POLY_TAB
+  NV_F64_XYMBR      mbr;                        //  Area bounds
+  std::vector<NV_F64_COORD2> polygon;           //  Polygon points (empty for a rectangle)
+  int32_t           box_size;                   //  Build box size in meters
+  int32_t           dwell;                      //  Cache update frequency in seconds
+  QString           out_dir;                    //  Base name of the saved cache segments
+  int32_t           status;                     //  JOB_PENDING, JOB_RUNNING, JOB_DONE, or JOB_FAILED
+  int32_t           exit_code;                  //  BATCH_ exit code of the last run of the job
+} BUILD_JOB;
+
+
 //  General stuff.
 
 typedef struct
@@ -104,23 +285,22 @@ typedef struct
   uint8_t           googleearth_available;      //  true if googleearth is available (and in the PATH)
   uint8_t           ge_linked;                  //  true if geCache and Google Earth area linked
   int32_t           second_count;               //  Second counter for cache update
-  double            box_size_x_deg;             //  Cache build viewing area box size in decimal degrees of longitude
-  double            box_size_y_deg;             //  Cache build viewing area box size in decimal degrees of latitude
   uint8_t           poly_flag;
-  uint8_t           view_flag;
   NV_F64_XYMBR      build_area_mbr;
   NV_F64_XYMBR      view_area_mbr;
+  BUILD_PLAN        plan;                       //  The boxes that will be visited during the build
+  COVERAGE_INDEX    coverage;                   //  The boxes that are already in the Google Earth cache directory
+  CACHE_SIZE        cache_size;                 //  Size of the Google Earth cache directory during a build
+  GE_READY          ge_ready;                   //  Startup readiness of the Google Earth that is running the build
+  QString           segment_base;               //  Base name of the segment directories for an unattended build
+  int32_t           segment_number;             //  Number of the next segment to be saved in an unattended build
+  uint8_t           batch_run;                  //  Set when the build is run from the command line (see batchBuild.cpp)
   int32_t           iterations;
   int32_t           poly_iterations;
   int32_t           total_rect_time;
   int32_t           total_poly_time;
-  double            x_border;
-  double            y_border;
-  QLabel            *meterWidth;
-  QLabel            *meterHeight;
-  QLabel            *rectEstTime;
-  QLabel            *numBoxes;
-  QLabel            *polyEstTime;
+  double            area_width;                 //  Width of the rectangle (meters) at its center latitude (set by computeSize)
+  double            area_height;                //  Height of the rectangle (meters) (set by computeSize)
 } MISC;
 
 
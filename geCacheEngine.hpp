@@ -0,0 +1,312 @@
+
+/********************************************************************************************* 
+
+    geCacheEngine.hpp
+
+    Copyright (c) 2016, Jan C. Depner
+
+
+    This file is part of geCache.
+
+    geCache is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    geCache is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with geCache.  If not, see <http://www.gnu.org/licenses/>.
+
+*********************************************************************************************/
+
+
+/*  geCache build engine definitions.  These don't use any widgets so the build can be run without the GUI.  */
+
+#ifndef _GECACHE_ENGINE_HPP_
+#define _GECACHE_ENGINE_HPP_
+
+#include <cmath>
+#include <cerrno>
+
+#include "geCacheDef.hpp"
+#include "version.hpp"
+
+
+using namespace std;
+
+
+uint8_t computeSize (MISC *misc, OPTIONS *options);
+uint8_t setBuildPlan (MISC *misc, OPTIONS *options);
+uint8_t makeBuildPlan (BUILD_PLAN *plan, NV_F64_XYMBR area_mbr, std::vector<int32_t> *box_size, std::vector<NV_F64_COORD2> *polygon,
+                       int32_t build_order, COVERAGE_INDEX *coverage);
+int32_t countBuildPlan (NV_F64_XYMBR area_mbr, std::vector<int32_t> *box_size);
+QString checkpointName (uint8_t batch_run);
+QString checkpointCacheDir (uint8_t batch_run);
+void writeCheckpoint (OPTIONS *options, MISC *misc, int32_t build_index, int32_t coverage_start, QString cache_snapshot);
+uint8_t readCheckpoint (OPTIONS *options, MISC *misc, int32_t *build_index, int32_t *box_count, int32_t *coverage_start, QString *cache_snapshot);
+void removeCheckpoint (MISC *misc);
+QString coverageName (const QString &cache_dir);
+void clearCoverage (COVERAGE_INDEX *coverage);
+uint8_t addCoverage (COVERAGE_INDEX *coverage, BUILD_PLAN *plan, int32_t start, int32_t end);
+uint8_t readCoverage (const QString &cache_dir, COVERAGE_INDEX *coverage);
+uint8_t writeCoverage (const QString &cache_dir, COVERAGE_INDEX *coverage);
+uint8_t indexCoverage (COVERAGE_INDEX *coverage);
+uint8_t boxCovered (COVERAGE_INDEX *coverage, NV_F64_XYMBR *mbr, int32_t box_size);
+void resetCacheSize (CACHE_SIZE *cache_size, const QString &cache_dir);
+void cacheSizeChanged (CACHE_SIZE *cache_size, const QString &path);
+int64_t cacheSize (CACHE_SIZE *cache_size);
+void addCacheSizeHistory (CACHE_SIZE *cache_size, int64_t size);
+int64_t projectCacheSize (CACHE_SIZE *cache_size);
+uint8_t cacheSizeRescanDue (CACHE_SIZE *cache_size);
+void rescanCacheSize (CACHE_SIZE *cache_size, DIR_FILES *dir_files, int64_t timestamp);
+void sizeDirs (const QString &path, DIR_FILES *dir_files);
+int64_t sizeDir (const QString &path);
+void listDir (const QString &path, QStringList *files, QStringList *subdirs);
+void startReadyCheck (GE_READY *ready, const char *kml_name);
+void stopReadyCheck (GE_READY *ready);
+uint8_t kmlRead (GE_READY *ready, const char *kml_name);
+uint8_t googleEarthSettled (GE_READY *ready, int64_t pid, int64_t last_activity, int64_t settle_ms);
+uint8_t copyDir (const QString &source, const QString &dest, COPY_STATS *stats = NULL);
+uint8_t snapshotDir (const QString &source, const QString &dest, COPY_STATS *stats = NULL);
+uint8_t swapDir (const QString &new_dir, const QString &dir, const QString &old_dir);
+QString tombstoneName (const QString &path);
+void removeDirLater (const QString &path);
+void sweepTombstones (const QString &dir);
+uint8_t cacheMounted (const QString &ge_dir);
+QString mountStageName (const QString &saved_dir);
+uint8_t stageCache (const QString &saved_dir, const QString &stage_dir, COPY_STATS *stats);
+uint8_t mountCache (const QString &target_dir, const QString &ge_dir);
+uint8_t unmountCache (const QString &ge_dir);
+uint8_t writeAreaFile (const QString &save_dir, OPTIONS *options);
+uint8_t readAreaFile (const QString &area_file, OPTIONS *options);
+int32_t batchBuild (int argc, char **argv);
+QString jobQueueName ();
+QString jobStatusText (int32_t status);
+void makeJob (OPTIONS *options, const QString &name, const QString &out_dir, BUILD_JOB *job);
+void setJobOptions (BUILD_JOB *job, OPTIONS *options);
+uint8_t readJobQueue (std::vector<BUILD_JOB> *jobs);
+uint8_t addJob (BUILD_JOB *job);
+uint8_t updateJob (BUILD_JOB *job);
+uint8_t resetJobQueue ();
+int32_t startNextJob (BUILD_JOB *job);
+uint8_t clearJobQueue ();
+void clearCopyStats (COPY_STATS *stats);
+QString copyStatsText (COPY_STATS *stats);
+
+
+//  Sizes a directory tree (see sizeDirs) on a thread pool thread.  When it's done it emits sized () and the receiver picks up
+//  the results and deletes it.
+
+class DirSizer:public QObject, public QRunnable
+{
+  Q_OBJECT
+
+
+public:
+
+  DirSizer (const QString &dir_path);
+  void run ();
+
+  QString         path;                         //  Directory being sized
+  int64_t         timestamp;                    //  Time (milliseconds since the epoch) that the sizer was created
+  DIR_FILES       dir_files;                    //  Size of each file in each directory of the tree
+  int64_t         total;                        //  Total size of the tree
+
+
+signals:
+
+  void sized ();
+};
+
+
+//  Copies a directory tree on a thread pool so that the GUI can show progress and let the user cancel (see copyDir.cpp).
+
+class CopyEngine
+{
+public:
+
+  CopyEngine (const QString &source_dir, const QString &dest_dir, int32_t limit, uint8_t link = false);
+  ~CopyEngine ();
+  uint8_t start ();
+  uint8_t wait (int32_t msecs);
+  void cancel ();
+  uint8_t succeeded ();
+  uint8_t canceled ();
+
+  QString         source;                       //  Directory being copied
+  QString         dest;                         //  Directory being copied to
+  int32_t         bandwidth_limit;              //  Maximum copy rate in megabytes per second (0 for no limit)
+  uint8_t         link_files;                   //  Hard link the files that Google Earth never rewrites (see snapshotDir)
+  int32_t         threads;                      //  Number of copy threads
+  int32_t         total_files;                  //  Number of files to copy
+  int64_t         total_bytes;                  //  Number of bytes to copy
+  QAtomicInt      files_done;                   //  Number of files copied so far
+  QAtomicInteger<qint64> bytes_done;            //  Number of bytes copied so far
+  COPY_STATS      stats;                        //  How the files were copied (valid after wait returns true)
+
+
+private:
+
+  friend class CopyWorker;
+
+  uint8_t walk ();
+
+  std::vector<QString> file;                    //  Files to copy (relative to source)
+  std::vector<int64_t> file_size;               //  Size of each file
+  QAtomicInt      next_file;                    //  Index of the next file to be copied
+  QAtomicInt      cancel_flag;                  //  Set to stop the copy
+  QAtomicInt      error_flag;                   //  Set if a file couldn't be copied
+  QMutex          stats_mutex;
+  QElapsedTimer   timer;
+  QThreadPool     pool;
+  uint8_t         finished;
+};
+
+
+//  Runs a cache build without any GUI (see buildEngine.cpp).  The geCache window (or anything else) starts it and listens to the
+//  signals.
+
+class BuildEngine:public QObject
+{
+  Q_OBJECT
+
+
+public:
+
+  BuildEngine (OPTIONS *op, MISC *mi, QObject *parent = 0);
+  ~BuildEngine ();
+  uint8_t start (uint8_t resume, int32_t start_index, int32_t start_coverage, const QString &snapshot);
+  void stop ();
+  uint8_t running ();
+  void pause (uint8_t paused);
+
+  int32_t         build_index;                  //  Index (in the plan) of the next box to be displayed
+  int32_t         coverage_start;               //  Index of the first box that has been added to the cache since it was last restored
+  int32_t         build_state;                  //  BUILD_DONE, BUILD_STARTING, etc.
+  QString         cache_snapshot;               //  Snapshot of the newly created cache directory
+
+
+signals:
+
+  void progress (int32_t value, int32_t remaining, int64_t cache_size);
+  void cacheFull ();
+  void copyProgress (int32_t files_done, int32_t total_files, int64_t bytes_done, int64_t total_bytes);
+  void segmentSaved (const QString &segment, const QString &stats);
+  void saveFailed ();
+  void finished ();
+  void stopped ();
+  void error (const QString &message);
+
+
+protected:
+
+  OPTIONS         *options;
+
+  MISC            *misc;
+
+  QProcess        *geProc;
+
+  QTimer          *timer;
+
+  QFileSystemWatcher *cacheWatcher;
+
+  DirSizer        *cache_sizer;
+
+  CopyEngine      *segment_copy;
+
+  QString         segment_dir;
+
+  uint8_t         segment_final;
+
+  char            ge_tmp_name[2][1024];
+
+  uint8_t         build_kill_flag;
+
+  int64_t         start_timestamp, cache_activity_timestamp, build_state_timestamp;
+
+
+  void setBuildState (int32_t state);
+  int64_t buildStateTime ();
+  void snapshotCache ();
+  void startCacheScan ();
+  void visitNextBox ();
+  void showNextBox (int64_t cache_size);
+  uint8_t finalOverviewDone ();
+  void finishBuild ();
+  void completeBuild ();
+  uint8_t startSegmentSave (uint8_t final);
+  void segmentSaveDone ();
+  void segmentFailed ();
+  void restartFromSnapshot ();
+  void watchCache ();
+  void restoreSnapshot ();
+  uint8_t dwellDone ();
+  uint8_t positionGoogleEarth ();
+
+
+protected slots:
+
+  void slotTimer ();
+  void slotCacheActivity (const QString &path);
+  void slotCacheSized ();
+  void slotGoogleEarthError (QProcess::ProcessError error_code);
+  void slotGoogleEarthDone (int exitCode, QProcess::ExitStatus exitStatus);
+};
+
+
+//  Runs a BuildEngine from the command line with no GUI and reports its progress on stdout (see batchBuild.cpp).
+
+class BatchBuild:public QObject
+{
+  Q_OBJECT
+
+
+public:
+
+  BatchBuild (QObject *parent = 0);
+  int32_t start (const QStringList &arguments);
+
+
+protected:
+
+  OPTIONS         options, base_options;
+
+  MISC            misc;
+
+  BuildEngine     *buildEngine;
+
+  QTimer          *signalTimer;
+
+  BUILD_JOB       job;
+
+  uint8_t         build_started, build_finished, build_errors, save_failed, queue_mode, settings_ok;
+
+  int32_t         exit_code, copy_percent, job_index, queue_exit_code;
+
+
+  int32_t startBuild (const QString &out_dir);
+  int32_t runNextJob ();
+  void jobDone (int32_t code);
+  void report (const QString &line);
+  int32_t finish (int32_t code);
+
+
+protected slots:
+
+  void slotProgress (int32_t value, int32_t remaining, int64_t cache_size);
+  void slotCopyProgress (int32_t files_done, int32_t total_files, int64_t bytes_done, int64_t total_bytes);
+  void slotSegmentSaved (const QString &segment, const QString &stats);
+  void slotFinished ();
+  void slotStopped ();
+  void slotError (const QString &message);
+  void slotSaveFailed ();
+  void slotExit ();
+  void slotCheckSignal ();
+};
+
+
+#endif
@@ -418,6 +418,31 @@ QString polyEstTimeText = geCache::tr
   ("This is the estimated amount of time it will take to build the cache based on the <b>Cache/preview area</b>, the <b>Cache build initial area "
    "size</b>, and <b>Cache build update frequency</b>.  Please note that this is only an estimate.");
 
+QString buildOrderText = geCache::tr
+  ("This is the order in which the viewing areas (<b>Cache build initial area size</b> squares) will be visited when building a new Google Earth "
+   "cache.  The options are:<br><br>"
+   "<ul>"
+   "<li><b>Serpentine</b> - the <b>Snake dance</b> described in the <b>Cache build initial area size</b> help.  West to east on the first row, "
+   "north one row, east to west on the next row, and so on.</li>"
+   "<li><b>Hilbert curve</b> - the viewing areas are visited along a space filling curve.  The view never jumps more than a few areas at a time "
+   "and it tends to stay in one neighborhood until that neighborhood is finished.</li>"
+   "<li><b>Nearest neighbor</b> - after each viewing area the view moves to the closest viewing area that hasn't been visited yet.</li>"
+   "</ul><br>"
+   "For rectangular areas <b>Serpentine</b> is usually the best choice.  For polygonal areas with ragged edges many rows may only contain a few viewing "
+   "areas with large gaps between them.  Every long jump makes Google Earth fly across the area, fetching imagery that will not be cached, so "
+   "<b>Hilbert curve</b> or <b>Nearest neighbor</b> will usually shorten the time spent at each viewing area.  If the cache size limit is reached "
+   "during a build, <b>Serpentine</b> redoes the current row after the cache has been saved while the other two orders only redo the last viewing area.");
+
+QString pyramidLevelsText = geCache::tr
+  ("This is an optional list of area sizes (in meters, separated by commas) for a pyramid cache build.  A normal cache build only visits "
+   "viewing areas of the <b>Cache build initial area size</b> so Google Earth only caches imagery at one resolution.  When you zoom out while "
+   "offline you will see gaps where the lower resolution overview imagery was never loaded.  For a pyramid build geCache makes a complete pass "
+   "over the area for each of these sizes that is larger than the <b>Cache build initial area size</b>, starting with the largest, before it "
+   "makes the normal pass at the <b>Cache build initial area size</b>.  The coarse passes have very few viewing areas so they are cheap.<br><br>"
+   "For example, with an initial area size of 3000 and pyramid sizes of <b>50000, 10000</b>, geCache will visit the area with 50 km viewing "
+   "areas, then 10 km viewing areas, and then 3 km viewing areas.  The estimated time to build and the progress bar include all of the levels.  "
+   "Leave this field empty for a normal (single level) build.  Sizes must be between 500 and 500000 meters.");
+
 QString boxSizeText = geCache::tr
   ("This is the area size (in meters) of the smallest area that will be used to build a new Google Earth cache.  The way the build process works for a "
    "rectangular area is that Google Earth will be started and zoomed to an area in the southwest corner of the <b>Cache/preview area</b> that is a square "
@@ -445,12 +470,64 @@ QString cacheUpdateText = geCache::tr
    "TIP: Using an area size of 1000 meters will cause the process to take quite a while to run.  I've found that 3000 meters is a "
    "reasonable area size and it will get pretty decent resolution images.</b>");
 
+QString adaptiveDwellText = geCache::tr
+  ("Check this box to move to the next viewing area as soon as Google Earth has finished loading the current one instead of always waiting "
+   "<b>Cache build update frequency</b> seconds.  While a cache build is running geCache watches the Google Earth cache directory for writes.  "
+   "Once Google Earth has been on an area for at least the <b>Min</b> number of seconds and hasn't written anything to the cache for the "
+   "<b>Settle</b> number of seconds, geCache moves on.  The <b>Cache build update frequency</b> is still the longest geCache will stay on one "
+   "area so dense areas that keep Google Earth busy get the full time.  On ocean and desert areas, or areas that are already in the cache, "
+   "this can cut the build time by more than half.  The estimated time is based on the update frequency so it is the longest the build "
+   "will take.<br><br>"
+   "<b>IMPORTANT NOTE: If Google Earth is slow to start fetching imagery on your network you may have to increase the <b>Min</b> or "
+   "<b>Settle</b> time.</b>");
+
 QString buildCacheText = geCache::tr
   ("Build a new Google Earth disk cache based on the area and options set in the <b>Cache</b> tab.  If the cache becomes too close to the maximum size you "
    "will be given the option to save the cache directory and continue or to cancel the build process.<br><br>"
    "<b>IMPORTANT NOTE: This button will be disabled if you are running Google Earth to preview an area. "
    "Also, it would be a bad idea to press this button if you are running Google Earth standalone.</b>");
 
+QString resumeBuildText = geCache::tr
+  ("Resume a Google Earth cache build that didn't finish.  While a cache build is running geCache saves its place (along with the area, polygon, "
+   "and build options) to a checkpoint file (geCache_checkpoint.ini in the same place as geCache.ini) after every viewing area.  If Google "
+   "Earth crashes, the machine goes down, or you kill the build, pressing this button will put the area and build options back the way they "
+   "were, restart Google Earth <b>without</b> clearing the Google Earth cache directory, and continue the build from the last viewing area "
+   "that was displayed.  The checkpoint is removed when a build finishes or a new build is started.<br><br>"
+   "<b>IMPORTANT NOTE: This button is only enabled when there is a build to resume for the current Google Earth cache directory.</b>");
+
+QString queueBuildText = geCache::tr
+  ("Add the area (rectangle or polygon), the area size, and the cache update frequency set in the <b>Cache</b> tab to the build job "
+   "queue.  You will be asked for a base name for the saved cache segments (for example <b>/stash/area</b>).  The queue is kept in "
+   "geCache_jobs.ini (in the same place as geCache.ini) and the jobs in it are run one after another, without the GUI, by running "
+   "<b>geCache --run-queue</b> (from a terminal, cron, or ssh).  Each job starts with an empty Google Earth cache and is saved to "
+   "numbered segments exactly like an <b>Unattended</b> build (<b>area_seg001</b>, <b>area_seg002</b>, ...).  Jobs that are done are "
+   "skipped, so if the queue is interrupted running it again picks up with the job that didn't finish.  <b>geCache --list-queue</b> "
+   "lists the jobs and <b>geCache --clear-queue</b> removes them.  Jobs can also be added from the command line (run "
+   "<b>geCache --help</b> for the details).<br><br>"
+   "<b>IMPORTANT NOTE: Everything other than the area, the area size, and the cache update frequency comes from your geCache settings "
+   "when the queue is run.</b>");
+
+QString incrementalBuildText = geCache::tr
+  ("Check this box to add to the Google Earth cache that is already there instead of starting from an empty cache.  geCache keeps a "
+   "coverage index (a list of the areas that have been cached and the area size that was used for each) next to the Google Earth cache "
+   "directory (<b>CACHE_DIR</b>_geCache.cov) and saves a copy of it with every saved cache.  When this box is checked, the Google Earth "
+   "cache directory is not cleared when a build is started and any viewing area that is completely covered by areas that were cached at "
+   "the same or a finer area size is skipped.  This makes it cheap to load a saved cache, extend the area (or add a neighboring polygon), "
+   "and build only the new part.  The number of areas to be cached that is shown in the status bar does not include the skipped areas.<br><br>"
+   "<b>IMPORTANT NOTE: Caches that were saved by older versions of geCache don't have a coverage index so nothing will be skipped when "
+   "they are loaded.</b>");
+
+QString unattendedBuildText = geCache::tr
+  ("Check this box to let a cache build run without anybody watching it.  When you press <b>Build cache</b> you will be asked for a "
+   "base name for the saved cache segments (for example <b>/stash/area</b>).  Whenever the cache reaches the <b>Cache size limit</b> it "
+   "is saved to the next segment directory (<b>area_seg001</b>, <b>area_seg002</b>, ...) without asking, the cache is put back the way it "
+   "was when the build started, and the build continues.  When the build finishes, the rest of the cache is saved to the last "
+   "segment.  A manifest (<b>area_geCache_segments.txt</b>) lists the first and last area of the build and the bounds that are in "
+   "each segment so that you know which segment to load for any part of the area.  This makes it possible to build large areas over "
+   "several days.<br><br>"
+   "<b>IMPORTANT NOTE: An unattended build can be resumed with <b>Resume build</b> and it will keep numbering the segments from where "
+   "it left off.</b>");
+
 QString killBuildCacheText = geCache::tr
   ("Kill the Google Earth process that is building a disk cache.");
 
@@ -513,5 +590,38 @@ QString iconSizeText = geCache::tr
    "<b>IMPORTANT NOTE: The button size will change when you select the size but the locations may not be entirely correct until you have exited "
    "and restarted the program.</b>");
 
+QString cacheLimitText = geCache::tr
+  ("Set the size (in megabytes) at which geCache will stop a cache build and ask you to save the Google Earth cache directory.  After the "
+   "cache is saved, the cache directory is put back the way it was when the build started and the build continues from where it left off.  "
+   "Set this a little below the maximum cache size that you have set in Google Earth (<b>Tools->Options->Cache->Disk Cache Size</b>).  "
+   "Google Earth throws away old imagery when the cache fills up so going past its limit loses imagery without any warning.<br><br>"
+   "geCache keeps track of how much the cache has grown over the last few areas and will stop before the next area is displayed if "
+   "it looks like that area would push the cache past the limit.");
+
+QString mountCacheText = geCache::tr
+  ("Check this box to <b>mount</b> saved caches instead of copying them when you press the <b>Load cache</b> button.  The Google "
+   "Earth cache directory is replaced with a link to the saved cache directory so switching between saved caches is instant and "
+   "the saved cache isn't duplicated on the disk.  The real cache directory is set aside and is put back when you load a cache "
+   "with this box unchecked or start a new cache build.<br><br>"
+   "<b>IMPORTANT NOTE: Google Earth writes straight into a mounted cache so anything you look at will be added to the saved cache.  "
+   "If you want to keep the saved cache the way it is, check <b>Protect</b> as well.  Mounting is not available on Windows.</b>");
+
+QString mountProtectText = geCache::tr
+  ("Check this box (along with <b>Mount</b>) to keep Google Earth from rewriting the index and lock files of a mounted saved "
+   "cache.  The saved cache is set up in a directory next to itself (with <b>_geCache_mount</b> added to the name) and the Google "
+   "Earth cache directory is linked to that directory.  The small files that Google Earth rewrites in place (the cache index and "
+   "the leveldb CURRENT, LOCK, LOG, MANIFEST, and .log files) are copied and the big data files are hard linked to the saved "
+   "cache, so this is nearly as quick as a plain mount and doesn't take up much more disk space.  The mount directory is deleted "
+   "when you mount another cache, load a cache with <b>Mount</b> unchecked, or start a new cache build.<br><br>"
+   "<b>IMPORTANT NOTE: Google Earth can still add data to the big files, but the saved cache's index won't point at it.  If you "
+   "want to keep what you looked at while the cache was mounted, save the cache.</b>");
+
+QString copyLimitText = geCache::tr
+  ("Set the maximum rate (in megabytes per second) at which geCache will copy files when it saves or loads a cache.  Set this to "
+   "<b>Unlimited</b> to copy as fast as the disks will go.  Limiting the rate keeps a big save to a slow USB disk or a network "
+   "share from making the rest of the system (including Google Earth) crawl.<br><br>"
+   "While a cache is being saved or loaded a progress dialog shows how many files and megabytes have been copied.  If you cancel "
+   "the copy the partial copy is removed.");
+
 QString closeText = geCache::tr
   ("Click this button to exit from the geCache program.  It will also kill any instance of Google Earth that you are running.");
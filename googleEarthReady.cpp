@@ -0,0 +1,228 @@
+
+/********************************************************************************************* 
+
+    googleEarthReady.cpp
+
+    Copyright (c) 2016, Jan C. Depner
+
+
+    This file is part of geCache.
+
+    geCache is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    geCache is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with geCache.  If not, see <http://www.gnu.org/licenses/>.
+
+*********************************************************************************************/
+
+
+
+#include "geCacheEngine.hpp"
+
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#endif
+
+
+/*!
+  These functions decide when the Google Earth that was started for a cache build is actually ready to go, instead of just
+  waiting a fixed amount of time.  Google Earth is ready when it has read the network link KML file (the one that we rewrite for
+  every box) and has stopped chewing up the CPU.  On Linux we watch the KML file for reads with inotify and add up the CPU time of
+  the Google Earth script and all of its descendants from /proc.  Everywhere else we check the KML file's access time, take a
+  write to the cache directory as a sign that the KML was read, and take a quiet cache directory as a sign that Google Earth has
+  settled down.  The build timer gives up waiting after GE_READY_TIMEOUT no matter what.
+*/
+
+#define GE_READY_CPU          0.25              //  Fraction of one CPU below which Google Earth is considered idle
+#define GE_READY_CPU_CHECKS   4                 //  Number of consecutive idle checks (at the build timer rate) to call it settled
+
+
+void startReadyCheck (GE_READY *ready, const char *kml_name)
+{
+  ready->kml_read = false;
+  ready->kml_atime = QFileInfo (QString (kml_name)).lastRead ().toMSecsSinceEpoch ();
+  ready->cpu_ticks = -1;
+  ready->cpu_timestamp = 0;
+  ready->idle_checks = 0;
+  ready->inotify_fd = -1;
+
+
+#ifdef __linux__
+
+  ready->inotify_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+
+  if (ready->inotify_fd >= 0 && inotify_add_watch (ready->inotify_fd, kml_name, IN_ACCESS | IN_CLOSE_NOWRITE) < 0)
+    {
+      close (ready->inotify_fd);
+      ready->inotify_fd = -1;
+    }
+
+#endif
+}
+
+
+
+void stopReadyCheck (GE_READY *ready)
+{
+#ifdef __linux__
+
+  if (ready->inotify_fd >= 0) close (ready->inotify_fd);
+
+#endif
+
+  ready->inotify_fd = -1;
+}
+
+
+
+//  Returns true once Google Earth has read the KML file.
+
+uint8_t kmlRead (GE_READY *ready, const char *kml_name)
+{
+  if (ready->kml_read) return (true);
+
+
+#ifdef __linux__
+
+  if (ready->inotify_fd >= 0)
+    {
+      char buf[4096] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+
+      if (read (ready->inotify_fd, buf, sizeof (buf)) > 0) ready->kml_read = true;
+
+      return (ready->kml_read);
+    }
+
+#endif
+
+
+  if (QFileInfo (QString (kml_name)).lastRead ().toMSecsSinceEpoch () > ready->kml_atime) ready->kml_read = true;
+
+  return (ready->kml_read);
+}
+
+
+
+#ifdef __linux__
+
+//  Total CPU time (in clock ticks) used by process pid and all of its descendants.
+
+static int64_t processTreeTicks (int64_t pid)
+{
+  QHash<int64_t, int64_t> ticks;
+  QMultiHash<int64_t, int64_t> children;
+
+
+  DIR *dir = opendir ("/proc");
+
+  if (!dir) return (-1);
+
+  struct dirent *entry;
+
+  while ((entry = readdir (dir)) != NULL)
+    {
+      if (entry->d_name[0] < '1' || entry->d_name[0] > '9') continue;
+
+      QFile file (QString ("/proc/%1/stat").arg (entry->d_name));
+
+      if (!file.open (QIODevice::ReadOnly)) continue;
+
+      QByteArray stat = file.readAll ();
+
+      file.close ();
+
+
+      //  The command name is in parentheses and may contain spaces so we start after the last ')'.  The fields after it are
+      //  state, ppid, ... with utime and stime at 12 and 13 (see proc(5)).
+
+      QList<QByteArray> field = stat.mid (stat.lastIndexOf (')') + 2).split (' ');
+
+      if (field.size () < 13) continue;
+
+      int64_t id = QByteArray (entry->d_name).toLongLong ();
+
+      ticks.insert (id, field.at (11).toLongLong () + field.at (12).toLongLong ());
+      children.insert (field.at (1).toLongLong (), id);
+    }
+
+  closedir (dir);
+
+
+  if (!ticks.contains (pid)) return (-1);
+
+  int64_t total = 0;
+  QList<int64_t> tree;
+  tree += pid;
+
+  for (int32_t i = 0 ; i < tree.size () ; i++)
+    {
+      total += ticks.value (tree.at (i));
+      tree += children.values (tree.at (i));
+    }
+
+  return (total);
+}
+
+#endif
+
+
+
+/*!
+  Returns true when Google Earth (process pid) has been idle for GE_READY_CPU_CHECKS calls in a row.  This is meant to be called
+  from the build timer.  Where we can't get the CPU time we say it's idle when the cache directory has been quiet (no writes since
+  last_activity) for settle_ms milliseconds.
+*/
+
+uint8_t googleEarthSettled (GE_READY *ready, int64_t pid, int64_t last_activity, int64_t settle_ms)
+{
+  int64_t now = QDateTime::currentMSecsSinceEpoch ();
+
+
+#ifdef __linux__
+
+  int64_t cpu_ticks = processTreeTicks (pid);
+
+  if (cpu_ticks >= 0)
+    {
+      if (ready->cpu_ticks >= 0 && now > ready->cpu_timestamp)
+        {
+          double cpu = (double) (cpu_ticks - ready->cpu_ticks) / (double) sysconf (_SC_CLK_TCK) / ((double) (now - ready->cpu_timestamp) / 1000.0);
+
+          if (cpu < GE_READY_CPU)
+            {
+              ready->idle_checks++;
+            }
+          else
+            {
+              ready->idle_checks = 0;
+            }
+        }
+
+      ready->cpu_ticks = cpu_ticks;
+      ready->cpu_timestamp = now;
+
+      return (ready->idle_checks >= GE_READY_CPU_CHECKS);
+    }
+
+#else
+
+  Q_UNUSED (pid);
+
+#endif
+
+
+  return (now - last_activity >= settle_ms);
+}
@@ -0,0 +1,366 @@
+
+/********************************************************************************************* 
+
+    jobQueue.cpp
+
+    Copyright (c) 2016, Jan C. Depner
+
+
+    This file is part of geCache.
+
+    geCache is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    geCache is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with geCache.  If not, see <http://www.gnu.org/licenses/>.
+
+*********************************************************************************************/
+
+
+
+#include "geCacheEngine.hpp"
+
+
+/*!
+  These functions keep the build job queue.  Each job is an area (a rectangle or a polygon) with its own box size, cache update
+  frequency, and save directory.  Jobs are added with the Queue build button or geCache --queue and are run one after another by
+  geCache --run-queue (see batchBuild.cpp).  The queue is a small .ini file (geCache_jobs.ini) that is stored in the same place
+  as geCache.ini.  Jobs can be added while the queue is being run so every change is a read-modify-write of the whole file while
+  holding a lock file (geCache_jobs.lock), and the runner finds its job by the job's id (not by where it is in the queue).  The
+  file is updated whenever a job is added or changes status so that a queue that was interrupted picks up where it left off.
+*/
+
+QString jobQueueName ()
+{
+#ifdef _MSC_VER
+  return (QString (getenv ("USERPROFILE")) + "/geCache_jobs.ini");
+#else
+  return (QString (getenv ("HOME")) + "/geCache_jobs.ini");
+#endif
+}
+
+
+
+//  Text for a job status (for listing the queue).
+
+QString jobStatusText (int32_t status)
+{
+  switch (status)
+    {
+    case JOB_PENDING:
+      return ("pending");
+
+    case JOB_RUNNING:
+      return ("running");
+
+    case JOB_DONE:
+      return ("done");
+    }
+
+  return ("failed");
+}
+
+
+
+//  Makes a job for the area in options (see readAreaFile).
+
+void makeJob (OPTIONS *options, const QString &name, const QString &out_dir, BUILD_JOB *job)
+{
+  job->name = name;
+  job->shape_tab = options->shape_tab;
+  job->mbr = options->cache_mbr;
+  job->polygon.clear ();
+  if (options->shape_tab == POLY_TAB) job->polygon = options->polygon;
+  job->box_size = options->build_box_size;
+  job->dwell = options->cache_update_frequency;
+  job->out_dir = out_dir;
+  job->id = QUuid::createUuid ().toString ();
+  job->status = JOB_PENDING;
+  job->exit_code = BATCH_OK;
+}
+
+
+
+//  Puts the job's area, box size, and cache update frequency into options.
+
+void setJobOptions (BUILD_JOB *job, OPTIONS *options)
+{
+  options->shape_tab = job->shape_tab;
+  options->cache_mbr = job->mbr;
+  options->polygon = job->polygon;
+  options->build_box_size = job->box_size;
+  options->cache_update_frequency = job->dwell;
+}
+
+
+
+//  The lock file that is held while the queue is read or changed.  QSettings uses geCache_jobs.ini.lock while it writes the file
+//  so we can't use that one.
+
+static QString jobLockName ()
+{
+  QString name = jobQueueName ();
+  name.chop (4);
+
+  return (name + ".lock");
+}
+
+
+
+//  Read the queue.  The caller has to hold the lock.
+
+static void loadJobs (std::vector<BUILD_JOB> *jobs)
+{
+  jobs->clear ();
+
+  if (!QFileInfo (jobQueueName ()).exists ()) return;
+
+
+  QSettings settings (jobQueueName (), QSettings::IniFormat);
+
+
+  //  Another geCache may have changed the file since we last looked at it.
+
+  settings.sync ();
+
+  int32_t size = settings.beginReadArray ("Jobs");
+
+  for (int32_t i = 0 ; i < size ; i++)
+    {
+      BUILD_JOB job;
+
+      settings.setArrayIndex (i);
+
+      job.id = settings.value (QString ("id"), QString ("")).toString ();
+      job.name = settings.value (QString ("name"), QString ("")).toString ();
+      job.shape_tab = settings.value (QString ("shape tab"), RECT_TAB).toInt ();
+      job.mbr.min_y = settings.value (QString ("south boundary latitude"), 0.0).toDouble ();
+      job.mbr.max_y = settings.value (QString ("north boundary latitude"), 0.0).toDouble ();
+      job.mbr.min_x = settings.value (QString ("west boundary longitude"), 0.0).toDouble ();
+      job.mbr.max_x = settings.value (QString ("east boundary longitude"), 0.0).toDouble ();
+
+
+      //  The polygon is stored as "lon,lat lon,lat ..." (the way KML does it).
+
+      QStringList points = settings.value (QString ("polygon"), QString ("")).toString ().split (" ", QString::SkipEmptyParts);
+
+      for (int32_t j = 0 ; j < points.size () ; j++)
+        {
+          QStringList values = points.at (j).split (",");
+
+          if (values.size () != 2) continue;
+
+          NV_F64_COORD2 pnt = {values.at (0).toDouble (), values.at (1).toDouble ()};
+          job.polygon.push_back (pnt);
+        }
+
+      job.box_size = settings.value (QString ("build box size"), 4000).toInt ();
+      job.dwell = settings.value (QString ("cache update frequency"), 6).toInt ();
+      job.out_dir = settings.value (QString ("save directory"), QString ("")).toString ();
+      job.status = settings.value (QString ("status"), JOB_PENDING).toInt ();
+      job.exit_code = settings.value (QString ("exit code"), BATCH_OK).toInt ();
+
+      jobs->push_back (job);
+    }
+
+  settings.endArray ();
+}
+
+
+
+//  Write the whole queue.  The caller has to hold the lock.
+
+static void saveJobs (std::vector<BUILD_JOB> *jobs)
+{
+  QSettings settings (jobQueueName (), QSettings::IniFormat);
+
+  settings.clear ();
+
+  settings.beginWriteArray ("Jobs");
+
+  for (uint32_t i = 0 ; i < jobs->size () ; i++)
+    {
+      BUILD_JOB *job = &jobs->at (i);
+
+      settings.setArrayIndex (i);
+
+      settings.setValue (QString ("id"), job->id);
+      settings.setValue (QString ("name"), job->name);
+      settings.setValue (QString ("shape tab"), job->shape_tab);
+      settings.setValue (QString ("south boundary latitude"), job->mbr.min_y);
+      settings.setValue (QString ("north boundary latitude"), job->mbr.max_y);
+      settings.setValue (QString ("west boundary longitude"), job->mbr.min_x);
+      settings.setValue (QString ("east boundary longitude"), job->mbr.max_x);
+
+      QStringList points;
+      for (uint32_t j = 0 ; j < job->polygon.size () ; j++)
+        points += QString ("%1,%2").arg (job->polygon[j].x, 0, 'f', 11).arg (job->polygon[j].y, 0, 'f', 11);
+      settings.setValue (QString ("polygon"), points.join (" "));
+
+      settings.setValue (QString ("build box size"), job->box_size);
+      settings.setValue (QString ("cache update frequency"), job->dwell);
+      settings.setValue (QString ("save directory"), job->out_dir);
+      settings.setValue (QString ("status"), job->status);
+      settings.setValue (QString ("exit code"), job->exit_code);
+    }
+
+  settings.endArray ();
+
+
+  //  Make sure it's on disk in case we die in the middle of the next job.
+
+  settings.sync ();
+}
+
+
+
+//  Reads the queue.  Returns false (with an empty queue) if we couldn't get the lock.
+
+uint8_t readJobQueue (std::vector<BUILD_JOB> *jobs)
+{
+  QLockFile lock (jobLockName ());
+
+  jobs->clear ();
+
+  if (!lock.tryLock (JOB_LOCK_WAIT)) return (false);
+
+  loadJobs (jobs);
+
+  return (true);
+}
+
+
+
+//  Adds a job to the end of the queue.  Returns false if we couldn't get the lock.
+
+uint8_t addJob (BUILD_JOB *job)
+{
+  QLockFile lock (jobLockName ());
+
+  if (!lock.tryLock (JOB_LOCK_WAIT)) return (false);
+
+
+  std::vector<BUILD_JOB> jobs;
+
+  loadJobs (&jobs);
+
+  jobs.push_back (*job);
+
+  saveJobs (&jobs);
+
+  return (true);
+}
+
+
+
+//  Replaces the job with the same id as job (e.g. to change its status).  Returns false if we couldn't get the lock or the job
+//  isn't in the queue anymore (the queue was cleared).
+
+uint8_t updateJob (BUILD_JOB *job)
+{
+  QLockFile lock (jobLockName ());
+
+  if (!lock.tryLock (JOB_LOCK_WAIT)) return (false);
+
+
+  std::vector<BUILD_JOB> jobs;
+
+  loadJobs (&jobs);
+
+  for (uint32_t i = 0 ; i < jobs.size () ; i++)
+    {
+      if (jobs[i].id == job->id)
+        {
+          jobs[i] = *job;
+          saveJobs (&jobs);
+          return (true);
+        }
+    }
+
+  return (false);
+}
+
+
+
+/*!
+  Gets the queue ready to be run.  A job that was running when the queue was interrupted gets started over, and jobs that were
+  queued by an older geCache get an id.  Returns false if we couldn't get the lock.
+*/
+
+uint8_t resetJobQueue ()
+{
+  QLockFile lock (jobLockName ());
+
+  if (!lock.tryLock (JOB_LOCK_WAIT)) return (false);
+
+
+  std::vector<BUILD_JOB> jobs;
+
+  loadJobs (&jobs);
+
+  for (uint32_t i = 0 ; i < jobs.size () ; i++)
+    {
+      if (jobs[i].status == JOB_RUNNING) jobs[i].status = JOB_PENDING;
+      if (jobs[i].id.isEmpty ()) jobs[i].id = QUuid::createUuid ().toString ();
+    }
+
+  saveJobs (&jobs);
+
+  return (true);
+}
+
+
+
+/*!
+  Re-reads the queue (so that jobs that were added since the last job was started are seen) and marks the first pending job as
+  running.  The job is put in job and its position in the queue (starting at 0) is returned.  Returns -1 if there are no pending
+  jobs or we couldn't get the lock.
+*/
+
+int32_t startNextJob (BUILD_JOB *job)
+{
+  QLockFile lock (jobLockName ());
+
+  if (!lock.tryLock (JOB_LOCK_WAIT)) return (-1);
+
+
+  std::vector<BUILD_JOB> jobs;
+
+  loadJobs (&jobs);
+
+  for (uint32_t i = 0 ; i < jobs.size () ; i++)
+    {
+      if (jobs[i].status == JOB_PENDING)
+        {
+          jobs[i].status = JOB_RUNNING;
+          saveJobs (&jobs);
+
+          *job = jobs[i];
+          return ((int32_t) i);
+        }
+    }
+
+  return (-1);
+}
+
+
+
+//  Removes every job from the queue.  Returns false if we couldn't get the lock.
+
+uint8_t clearJobQueue ()
+{
+  QLockFile lock (jobLockName ());
+
+  if (!lock.tryLock (JOB_LOCK_WAIT)) return (false);
+
+  if (QFileInfo (jobQueueName ()).exists ()) return (QFile (jobQueueName ()).remove ());
+
+  return (true);
+}
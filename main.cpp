@@ -32,6 +32,14 @@
 int
 main (int argc, char **argv)
 {
+    //  geCache --build ..., --run-queue, etc. run without the GUI (see batchBuild.cpp).  Qt's own options only have one dash.
+
+    for (int32_t i = 1 ; i < argc ; i++)
+      {
+        if (!strncmp (argv[i], "--", 2)) return (batchBuild (argc, argv));
+      }
+
+
     QApplication a (argc, argv);
 
 #ifdef _MSC_VER
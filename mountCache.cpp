@@ -0,0 +1,236 @@
+
+/********************************************************************************************* 
+
+    mountCache.cpp
+
+    Copyright (c) 2016, Jan C. Depner
+
+
+    This file is part of geCache.
+
+    geCache is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    geCache is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with geCache.  If not, see <http://www.gnu.org/licenses/>.
+
+*********************************************************************************************/
+
+
+
+#include "geCacheEngine.hpp"
+
+
+#ifndef _MSC_VER
+
+#include <unistd.h>
+
+#endif
+
+
+/*!
+  These functions "mount" a saved cache by replacing the Google Earth cache directory with a symbolic link to the saved cache
+  directory.  Switching between saved caches is then just a matter of changing the link.  Google Earth writes straight through the
+  link so a mounted cache is updated in place.  To protect the saved cache the caller can stage it next to itself first
+  (stageCache) and mount the stage instead.  The stage copies the small files that Google Earth rewrites in place (the dbCache
+  index and the leveldb CURRENT, LOCK, LOG, MANIFEST, and .log files) and hard links everything else, so staging is nearly as
+  quick as a plain mount and doesn't duplicate the big data files.  The stage is removed when something else is mounted or the
+  cache is unmounted.  The real cache directory is renamed to ge_dir_geCache_local while a saved cache is mounted and put back when
+  it's unmounted.  Windows needs special privileges to make symbolic links so this is only available on Linux (and other Unix
+  systems).
+*/
+
+#define MOUNT_STAGE  "_geCache_mount"
+
+
+static QString localName (const QString &ge_dir)
+{
+  return (ge_dir + "_geCache_local");
+}
+
+
+
+//  Remove the stage that the Google Earth cache directory link was pointing at (if it was one of ours).
+
+static void removeStage (const QString &target)
+{
+  if (target.endsWith (MOUNT_STAGE)) removeDirLater (target);
+}
+
+
+
+//  Returns the name of the directory that saved_dir is staged in for mounting (see the top of this file).
+
+QString mountStageName (const QString &saved_dir)
+{
+  return (QDir::cleanPath (QDir (saved_dir).absolutePath ()) + MOUNT_STAGE);
+}
+
+
+
+#ifndef _MSC_VER
+
+//  Returns true for the small files that Google Earth rewrites in place (see the top of this file).
+
+static uint8_t stageCopy (const QString &name)
+{
+  return (name.endsWith (".index") || name.endsWith (".log") || name == "CURRENT" || name == "LOCK" || name.startsWith ("LOG") ||
+          name.startsWith ("MANIFEST"));
+}
+
+#endif
+
+
+
+//  Stage saved_dir in stage_dir (see the top of this file).  The stage has to be on the same file system as the saved cache
+//  (mountStageName puts it next to it).  Returns false (after removing the partial stage) if it couldn't be done.
+
+uint8_t stageCache (const QString &saved_dir, const QString &stage_dir, COPY_STATS *stats)
+{
+  clearCopyStats (stats);
+
+#ifdef _MSC_VER
+
+  Q_UNUSED (saved_dir);
+  Q_UNUSED (stage_dir);
+
+  return (false);
+
+#else
+
+  QString root = QDir::cleanPath (QDir (saved_dir).absolutePath ());
+
+  DIR_FILES dir_files;
+
+  sizeDirs (root, &dir_files);
+
+  if (dir_files.isEmpty ()) return (false);
+
+
+  for (DIR_FILES::const_iterator it = dir_files.constBegin () ; it != dir_files.constEnd () ; ++it)
+    {
+      QString dir = it.key ().mid (root.length () + 1);
+      QString dest_dir = dir.isEmpty () ? stage_dir : stage_dir + "/" + dir;
+
+      if (!QDir ().mkpath (dest_dir))
+        {
+          removeDirLater (stage_dir);
+          return (false);
+        }
+
+      for (QHash<QString, int64_t>::const_iterator f = it.value ().constBegin () ; f != it.value ().constEnd () ; ++f)
+        {
+          QString source = it.key () + "/" + f.key ();
+          QString dest = dest_dir + "/" + f.key ();
+          int32_t strategy = COPY_HARDLINK;
+
+          if (stageCopy (f.key ()))
+            {
+              strategy = COPY_QFILE;
+
+              if (!QFile::copy (source, dest))
+                {
+                  removeDirLater (stage_dir);
+                  return (false);
+                }
+            }
+          else if (link (QFile::encodeName (source).constData (), QFile::encodeName (dest).constData ()))
+            {
+              removeDirLater (stage_dir);
+              return (false);
+            }
+
+          stats->files[strategy]++;
+          stats->bytes[strategy] += f.value ();
+        }
+    }
+
+  return (true);
+
+#endif
+}
+
+
+
+//  Returns true if a saved cache is mounted on the Google Earth cache directory.
+
+uint8_t cacheMounted (const QString &ge_dir)
+{
+  return (QFileInfo (ge_dir).isSymLink ());
+}
+
+
+
+//  Point the Google Earth cache directory at target_dir (a saved cache or its stage).  Returns false if it couldn't be done (the
+//  cache directory is unchanged).
+
+uint8_t mountCache (const QString &target_dir, const QString &ge_dir)
+{
+#ifdef _MSC_VER
+
+  Q_UNUSED (target_dir);
+  Q_UNUSED (ge_dir);
+
+  return (false);
+
+#else
+
+  QString link_name = ge_dir + "_geCache_link";
+
+
+  QFile::remove (link_name);
+
+  if (symlink (QFile::encodeName (QDir (target_dir).absolutePath ()).constData (), QFile::encodeName (link_name).constData ())) return (false);
+
+
+  //  If we're switching from one saved cache to another we can just replace the link (rename will do that atomically).
+
+  if (cacheMounted (ge_dir))
+    {
+      QString old_stage = QFileInfo (ge_dir).symLinkTarget ();
+
+      if (!rename (QFile::encodeName (link_name).constData (), QFile::encodeName (ge_dir).constData ()))
+        {
+          //  If the same saved cache was staged again the old stage has already been removed (see geCache::slotLoadCacheClicked).
+
+          if (QDir::cleanPath (old_stage) != QDir::cleanPath (QDir (target_dir).absolutePath ())) removeStage (old_stage);
+          return (true);
+        }
+    }
+  else
+    {
+      if (!QFileInfo (localName (ge_dir)).exists () && swapDir (link_name, ge_dir, localName (ge_dir))) return (true);
+    }
+
+  QFile::remove (link_name);
+
+  return (false);
+
+#endif
+}
+
+
+
+//  Put the real Google Earth cache directory back (or make an empty one if there wasn't one).
+
+uint8_t unmountCache (const QString &ge_dir)
+{
+  if (!cacheMounted (ge_dir)) return (true);
+
+  QString stage = QFileInfo (ge_dir).symLinkTarget ();
+
+  if (!QFile::remove (ge_dir)) return (false);
+
+  removeStage (stage);
+
+  if (QFileInfo (localName (ge_dir)).isDir ()) return (QDir ().rename (localName (ge_dir), ge_dir));
+
+  return (QDir ().mkpath (ge_dir));
+}
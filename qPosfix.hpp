@@ -48,9 +48,6 @@
 
 #include <QtCore>
 #include <QtGui>
-#if QT_VERSION >= 0x050000
-#include <QtWidgets>
-#endif
 
 
 #define QPOS_LAT             0
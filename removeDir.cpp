@@ -0,0 +1,173 @@
+
+/********************************************************************************************* 
+
+    removeDir.cpp
+
+    Copyright (c) 2016, Jan C. Depner
+
+
+    This file is part of geCache.
+
+    geCache is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    geCache is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with geCache.  If not, see <http://www.gnu.org/licenses/>.
+
+*********************************************************************************************/
+
+
+
+#include "geCacheEngine.hpp"
+
+
+#ifdef __linux__
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+
+/*!
+  These functions remove directory trees in the background.  Deleting tens of thousands of cache files can take a long time and
+  there's no reason to make the user watch it happen.  removeDirLater renames the directory to a tombstone name (the original name
+  with _geCache_tomb_ and a time stamp appended) right away, so as far as everyone else is concerned it's gone, and then deletes the
+  tombstone on a single low priority thread.  If geCache exits (or crashes) before a tombstone is gone it will be found and removed
+  by sweepTombstones the next time geCache starts.
+*/
+
+#define TOMBSTONE         "_geCache_tomb_"
+
+
+//  The tombstones are removed one at a time on their own thread pool.  The pool is never deleted so that exiting doesn't have to
+//  wait for it (whatever is left will be swept up next time).
+
+static QThreadPool *removePool ()
+{
+  static QThreadPool *pool = NULL;
+
+  if (!pool)
+    {
+      pool = new QThreadPool;
+      pool->setMaxThreadCount (1);
+    }
+
+  return (pool);
+}
+
+
+
+class DirRemover:public QRunnable
+{
+public:
+
+  DirRemover (const QString &dir_path)
+  {
+    path = dir_path;
+  }
+
+  void run ()
+  {
+#ifdef __linux__
+
+    //  Be as nice as possible about the CPU and the disk (idle I/O class, see ioprio_set(2)).
+
+    setpriority (PRIO_PROCESS, (id_t) syscall (SYS_gettid), 19);
+
+#ifdef SYS_ioprio_set
+
+    syscall (SYS_ioprio_set, 1, 0, 3 << 13);
+
+#endif
+
+#else
+
+    QThread::currentThread ()->setPriority (QThread::LowestPriority);
+
+#endif
+
+
+    //  Don't follow a symbolic link (e.g. a mounted cache, see mountCache.cpp) into the directory it points to.
+
+    if (QFileInfo (path).isSymLink ())
+      {
+        QFile::remove (path);
+      }
+    else
+      {
+        QDir (path).removeRecursively ();
+      }
+  }
+
+  QString path;
+};
+
+
+
+//  Returns a new tombstone name for path (in the same directory so that the rename is atomic).
+
+QString tombstoneName (const QString &path)
+{
+  static int32_t count = 0;
+
+  return (path + QString (TOMBSTONE "%1_%2").arg (QDateTime::currentMSecsSinceEpoch ()).arg (count++));
+}
+
+
+
+//  Remove path (a directory, or a link to one) in the background.  If it can't be renamed to a tombstone we remove it right here.
+
+void removeDirLater (const QString &path)
+{
+  QFileInfo info (path);
+
+  if (!info.exists () && !info.isSymLink ()) return;
+
+  QString tomb = path;
+
+  if (!info.fileName ().contains (TOMBSTONE))
+    {
+      tomb = tombstoneName (path);
+
+      if (!QDir ().rename (path, tomb))
+        {
+          if (info.isSymLink ())
+            {
+              QFile::remove (path);
+            }
+          else
+            {
+              QDir (path).removeRecursively ();
+            }
+
+          return;
+        }
+    }
+
+  removePool ()->start (new DirRemover (tomb));
+}
+
+
+
+//  Queue any tombstones (and half built cache stages) that were left in dir by an earlier run of geCache.
+
+void sweepTombstones (const QString &dir)
+{
+  if (dir.isEmpty () || !QDir (dir).exists ()) return;
+
+  QStringList filters;
+  filters << "*" TOMBSTONE "*" << "*_geCache_load" << "*_geCache_link" << "cache_snapshot_next";
+
+  QFileInfoList list = QDir (dir).entryInfoList (filters, QDir::Dirs | QDir::Files | QDir::System | QDir::Hidden | QDir::NoDotAndDotDot);
+
+  for (int32_t i = 0 ; i < list.size () ; i++) removeDirLater (list.at (i).absoluteFilePath ());
+}
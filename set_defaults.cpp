@@ -38,6 +38,16 @@ void set_defaults (MISC *misc, OPTIONS *options, uint8_t reset)
 
       misc->ge_linked = 0;
       misc->second_count = 0;
+      misc->coverage.dirty = true;
+      misc->coverage.serial = 0;
+      misc->plan.valid = false;
+      misc->cache_size.total = 0;
+      misc->cache_size.scan_timestamp = 0;
+      misc->cache_size.sized = false;
+      misc->segment_number = 1;
+      misc->batch_run = false;
+      misc->ge_ready.inotify_fd = -1;
+      misc->area_width = misc->area_height = 0.0;
     }
 
   options->cache_mbr.min_x = -81.63642;
@@ -45,11 +55,22 @@ void set_defaults (MISC *misc, OPTIONS *options, uint8_t reset)
   options->cache_mbr.max_x = -81.48429;
   options->cache_mbr.max_y = 28.45114;
   options->position_form = 0;
-  options->font = QApplication::font ();
+  options->font = QGuiApplication::font ();
   options->stash_dir = ".";
   options->build_box_size = 4000;
   options->cache_update_frequency = 6;
+  options->adaptive_dwell = false;
+  options->dwell_min = 3;
+  options->dwell_settle = 2;
+  options->build_order = BUILD_ORDER_SERPENTINE;
+  options->pyramid_levels.clear ();
+  options->incremental_build = false;
+  options->unattended_build = false;
   options->icon_size = 32;
+  options->cache_size_limit = 2000;
+  options->copy_bandwidth_limit = 0;
+  options->mount_cache = false;
+  options->mount_protect = false;
   options->warning_color = QColor (255, 0, 0, 255);
   options->start_tab = ABOUT_TAB;
   options->shape_tab = RECT_TAB;
@@ -85,10 +106,11 @@ void set_defaults (MISC *misc, OPTIONS *options, uint8_t reset)
     }
   else
     {
-      //  This should NEVER happen
+      //  This should NEVER happen (and if it does in a batch build there are no widgets to show it with).
 
-      QMessageBox::warning (0, geCache::tr ("geCache Error"),
-                            geCache::tr ("$USERPROFILE environment variable not set!\nYou will have to set your Google Earth folder name manually in the <b>Preferences</b> tab."));
+      if (qobject_cast<QApplication *> (QCoreApplication::instance ()))
+        QMessageBox::warning (0, geCache::tr ("geCache Error"),
+                              geCache::tr ("$USERPROFILE environment variable not set!\nYou will have to set your Google Earth folder name manually in the <b>Preferences</b> tab."));
 
       options->ge_dir = "AppData\\Local\\Google\\GoogleEarth";
     }
@@ -117,10 +139,11 @@ void set_defaults (MISC *misc, OPTIONS *options, uint8_t reset)
     }
   else
     { 
-      //  This should NEVER happen
+      //  This should NEVER happen (and if it does in a batch build there are no widgets to show it with).
 
-      QMessageBox::warning (0, geCache::tr ("geCache Error"),
-                            geCache::tr ("$HOME environment variable not set!\nYou will have to set your Google Earth folder name manually in the <b>Preferences</b> tab."));
+      if (qobject_cast<QApplication *> (QCoreApplication::instance ()))
+        QMessageBox::warning (0, geCache::tr ("geCache Error"),
+                              geCache::tr ("$HOME environment variable not set!\nYou will have to set your Google Earth folder name manually in the <b>Preferences</b> tab."));
 
       options->ge_dir = ".googleearth/Cache";
     }
@@ -24,34 +24,341 @@
 *********************************************************************************************/
 
 
-#include "geCacheDef.hpp"
+#include "geCacheEngine.hpp"
 
-int64_t sizeDir (const QString &path)
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#endif
+
+
+/*!
+  These functions compute the size of a directory tree.  sizeDirs returns the size of every file in each directory of the tree so
+  that the cache size tracker (cacheSize.cpp) and CopyEngine (copyDir.cpp) can work a file at a time.  sizeDir just returns the
+  total.  listDir just reads the names in a directory (without stat'ing anything) so that the tracker can find the files that have
+  been added or removed.  The subdirectories of the top directory are sized in parallel on a small thread pool.  On Linux each
+  directory is read with readdir (getdents64) and the files are stat'ed relative to the open directory (with statx, when we have
+  it, so that network mounts don't have to sync the file attributes) instead of building a QFileInfoList.  Directories and
+  symbolic links are recognized from the directory entry type so they don't get stat'ed at all.  DirSizer runs sizeDirs on the
+  global thread pool and lets the GUI know when it's done.
+*/
+
+#define SIZE_DIR_THREADS  4
+
+
+#ifdef __linux__
+
+//  Size the files in one directory and return its subdirectories.
+
+static void sizeOneDir (const QString &path, DIR_FILES *dir_files, QStringList *subdirs)
 {
-  int64_t total_size = 0;
+  QHash<QString, int64_t> files;
+
+
+  int32_t dir_fd = open (QFile::encodeName (path).constData (), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+  if (dir_fd < 0) return;
+
+  DIR *dir = fdopendir (dir_fd);
+
+  if (dir == NULL)
+    {
+      close (dir_fd);
+      return;
+    }
 
-  QFileInfo pathInfo (path);
 
-  if (pathInfo.isDir ())
+  struct dirent *ent;
+
+  while ((ent = readdir (dir)) != NULL)
     {
-      QDir dir (path);
+      if (!strcmp (ent->d_name, ".") || !strcmp (ent->d_name, "..")) continue;
+
 
-      QFileInfoList list = dir.entryInfoList (QDir::Files | QDir::Dirs | QDir::Hidden | QDir::System| QDir::NoSymLinks | QDir::NoDotAndDotDot);
+      //  Like QDir::NoSymLinks, we don't follow (or count) symbolic links.
 
-      for (int32_t i = 0; i < list.size (); i++)
+      if (ent->d_type == DT_LNK) continue;
+
+      if (ent->d_type == DT_DIR)
+        {
+          subdirs->append (path + "/" + QFile::decodeName (ent->d_name));
+          continue;
+        }
+
+
+      //  Some file systems don't fill in d_type so we may still run into directories here.
+
+#ifdef STATX_SIZE
+
+      struct statx stx;
+
+      if (statx (dir_fd, ent->d_name, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, STATX_TYPE | STATX_SIZE, &stx)) continue;
+
+      if (S_ISLNK (stx.stx_mode)) continue;
+
+      if (S_ISDIR (stx.stx_mode))
         {
-          QFileInfo fileInfo = list.at (i);
+          subdirs->append (path + "/" + QFile::decodeName (ent->d_name));
+        }
+      else
+        {
+          files.insert (QFile::decodeName (ent->d_name), (int64_t) stx.stx_size);
+        }
+
+#else
+
+      struct stat st;
+
+      if (fstatat (dir_fd, ent->d_name, &st, AT_SYMLINK_NOFOLLOW)) continue;
+
+      if (S_ISLNK (st.st_mode)) continue;
+
+      if (S_ISDIR (st.st_mode))
+        {
+          subdirs->append (path + "/" + QFile::decodeName (ent->d_name));
+        }
+      else
+        {
+          files.insert (QFile::decodeName (ent->d_name), (int64_t) st.st_size);
+        }
+
+#endif
+    }
+
+  closedir (dir);
+
+  dir_files->insert (path, files);
+}
+
+#else
+
+//  Size the files in one directory and return its subdirectories.
+
+static void sizeOneDir (const QString &path, DIR_FILES *dir_files, QStringList *subdirs)
+{
+  QHash<QString, int64_t> files;
+
+  QFileInfoList list = QDir (path).entryInfoList (QDir::Files | QDir::Dirs | QDir::Hidden | QDir::System | QDir::NoSymLinks | QDir::NoDotAndDotDot);
+
+  for (int32_t i = 0 ; i < list.size () ; i++)
+    {
+      if (list.at (i).isDir ())
+        {
+          subdirs->append (list.at (i).absoluteFilePath ());
+        }
+      else
+        {
+          files.insert (list.at (i).fileName (), list.at (i).size ());
+        }
+    }
+
+  dir_files->insert (path, files);
+}
+
+#endif
+
+
+
+//  Read the names of the files and subdirectories in a directory.  Nothing is stat'ed unless the file system doesn't give us the
+//  entry type.  Symbolic links are skipped (like sizeOneDir).
+
+void listDir (const QString &path, QStringList *files, QStringList *subdirs)
+{
+#ifdef __linux__
+
+  int32_t dir_fd = open (QFile::encodeName (path).constData (), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+  if (dir_fd < 0) return;
+
+  DIR *dir = fdopendir (dir_fd);
+
+  if (dir == NULL)
+    {
+      close (dir_fd);
+      return;
+    }
+
+
+  struct dirent *ent;
+
+  while ((ent = readdir (dir)) != NULL)
+    {
+      if (!strcmp (ent->d_name, ".") || !strcmp (ent->d_name, "..")) continue;
+
+      uint8_t type = ent->d_type;
+
+      if (type == DT_UNKNOWN)
+        {
+          struct stat st;
+
+          if (fstatat (dir_fd, ent->d_name, &st, AT_SYMLINK_NOFOLLOW)) continue;
+
+          type = S_ISLNK (st.st_mode) ? DT_LNK : S_ISDIR (st.st_mode) ? DT_DIR : DT_REG;
+        }
+
+      if (type == DT_LNK) continue;
 
-          if(fileInfo.isDir ())
-            {
-              total_size += sizeDir (fileInfo.absoluteFilePath ());
-            }
-          else
-            {
-              total_size += fileInfo.size ();
-            }
+      if (type == DT_DIR)
+        {
+          subdirs->append (path + "/" + QFile::decodeName (ent->d_name));
         }
+      else
+        {
+          files->append (QFile::decodeName (ent->d_name));
+        }
+    }
+
+  closedir (dir);
+
+#else
+
+  QDir dir (path);
+
+  *files += dir.entryList (QDir::Files | QDir::Hidden | QDir::System | QDir::NoSymLinks);
+
+  QStringList names = dir.entryList (QDir::Dirs | QDir::Hidden | QDir::System | QDir::NoSymLinks | QDir::NoDotAndDotDot);
+
+  for (int32_t i = 0 ; i < names.size () ; i++) subdirs->append (path + "/" + names.at (i));
+
+#endif
+}
+
+
+
+//  Size a directory and everything under it.
+
+static void sizeTree (const QString &path, DIR_FILES *dir_files)
+{
+  QStringList subdirs;
+
+  sizeOneDir (path, dir_files, &subdirs);
+
+  for (int32_t i = 0 ; i < subdirs.size () ; i++) sizeTree (subdirs.at (i), dir_files);
+}
+
+
+
+//  One subtree of the top directory, sized on a pool thread.
+
+class SubtreeSizer:public QRunnable
+{
+public:
+
+  SubtreeSizer (const QString &subtree_path)
+  {
+    path = subtree_path;
+    setAutoDelete (false);
+  }
+
+  void run ()
+  {
+    sizeTree (path, &dir_files);
+  }
+
+  QString path;
+  DIR_FILES dir_files;
+};
+
+
+
+//  Compute the size of every file in each directory of the tree under path.  The directory names are cleaned up absolute paths.
+
+void sizeDirs (const QString &path, DIR_FILES *dir_files)
+{
+  QStringList subdirs;
+
+
+  dir_files->clear ();
+
+  if (!QFileInfo (path).isDir ()) return;
+
+  sizeOneDir (QDir::cleanPath (QDir (path).absolutePath ()), dir_files, &subdirs);
+
+
+  //  Not worth starting threads for.
+
+  if (subdirs.size () < 2)
+    {
+      for (int32_t i = 0 ; i < subdirs.size () ; i++) sizeTree (subdirs.at (i), dir_files);
+      return;
+    }
+
+
+  QThreadPool pool;
+  pool.setMaxThreadCount (qMin (SIZE_DIR_THREADS, subdirs.size ()));
+
+  std::vector<SubtreeSizer *> sizer;
+
+  for (int32_t i = 0 ; i < subdirs.size () ; i++)
+    {
+      sizer.push_back (new SubtreeSizer (subdirs.at (i)));
+      pool.start (sizer.back ());
+    }
+
+  pool.waitForDone ();
+
+  for (uint32_t i = 0 ; i < sizer.size () ; i++)
+    {
+      for (DIR_FILES::const_iterator it = sizer[i]->dir_files.constBegin () ; it != sizer[i]->dir_files.constEnd () ; ++it)
+        dir_files->insert (it.key (), it.value ());
+
+      delete sizer[i];
+    }
+}
+
+
+
+//  Add up the file sizes from sizeDirs.
+
+static int64_t totalSize (DIR_FILES *dir_files)
+{
+  int64_t total_size = 0;
+
+  for (DIR_FILES::const_iterator it = dir_files->constBegin () ; it != dir_files->constEnd () ; ++it)
+    {
+      for (QHash<QString, int64_t>::const_iterator f = it.value ().constBegin () ; f != it.value ().constEnd () ; ++f) total_size += f.value ();
     }
 
   return (total_size);
-} 
+}
+
+
+
+//  Returns the total size of the files in the tree under path (e.g. a saved cache or the stash directory).
+
+int64_t sizeDir (const QString &path)
+{
+  DIR_FILES dir_files;
+
+
+  sizeDirs (path, &dir_files);
+
+  return (totalSize (&dir_files));
+}
+
+
+
+DirSizer::DirSizer (const QString &dir_path)
+{
+  path = dir_path;
+  timestamp = QDateTime::currentMSecsSinceEpoch ();
+  total = 0;
+
+  setAutoDelete (false);
+}
+
+
+
+void DirSizer::run ()
+{
+  sizeDirs (path, &dir_files);
+
+  total = totalSize (&dir_files);
+
+  emit sized ();
+}
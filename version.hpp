@@ -26,7 +26,7 @@
 
 #ifndef VERSION
 
-#define     VERSION     "PFM Software - geCache V1.05 - 01/15/21"
+#define     VERSION     "PFM Software - geCache V1.06 - 10/17/26"
 
 #endif
 
@@ -83,4 +83,67 @@
     - Fixed the NW corner button.  I wasn't checking for bounds_clicked = NO_BOUNDS, I was checking
       for bounds_clicked being non-zero.  NW corner is zero, DOH!
 
+
+    Version 1.06
+    Jan C. Depner (PFM Software)
+    10/17/26
+
+    - The boxes to be visited during a cache build are now computed once (in computeSize) and stored in a build plan.  The
+      estimate, the progress bar, the build timer, and the row restart after saving a full cache all use the plan.  This also
+      fixes the extra column of boxes west of the area that was being visited on every east to west row.
+    - The boxes that overlap a build polygon are now found with a scanline rasterizer (polygon_grid_coverage) instead of calling
+      polygon_intersection for every box in the polygon's MBR.
+    - Added a selectable cache build order (Serpentine, Hilbert curve, or Nearest neighbor).  The last two keep Google Earth
+      from flying across ragged polygons (and fetching imagery we don't want) on the way to the next box.
+    - The cache build box width (in degrees of longitude) and the display borders are now computed for each row of boxes at
+      that row's latitude instead of once at the center of the area.  Tall areas no longer get boxes that are too wide on the
+      equatorward side and too narrow on the poleward side.
+    - Added pyramid cache builds.  The user can give a list of coarser area sizes that are visited, coarse to fine, before the
+      normal pass so that the overview imagery is cached too.  The estimate and the progress bar cover all of the levels.
+    - Cache builds now write a checkpoint file after every box.  The new "Resume build" button restores the area, the build
+      options, the plan position, the progress bar, and the cache snapshot and continues an interrupted build.
+    - Added incremental cache builds.  A coverage index of the boxes that have been cached (and their area sizes) is kept next to
+      the Google Earth cache directory and saved with every saved cache.  With "Incremental" checked, the cache isn't cleared
+      and boxes that are already covered at the same or a finer area size are left out of the build plan.
+    - The number of boxes in a rectangle build is now computed directly from the grid dimensions instead of generating the plan
+      every time the bounds or the area size change.  The polygon build plan is only regenerated when its inputs change.
+    - Added adaptive dwell.  geCache watches the Google Earth cache directory during a build and moves to the next box as soon as
+      Google Earth has stopped writing for the settle time (bounded by the minimum dwell and the cache update frequency).
+    - The size of the Google Earth cache is now tracked during a build from the cache watcher's change notifications instead of
+      walking the whole cache directory every update period.  Only the files that have changed are stat'ed (a changed directory
+      is just read for added and removed files).  A full scan is only done at the start and every five minutes.
+    - Directory sizing now uses readdir and statx on Linux, sizes the top level subdirectories in parallel, and the full scans
+      of the cache during a build (at the start, after the snapshot is put back, and every five minutes) run in the background.
+    - The cache size limit is now a preference instead of being hard-coded and the build stops to save the cache when the growth
+      over the last few boxes says the next box would push the cache past the limit.
+    - Added unattended cache builds.  When the cache fills up it is saved to the next numbered segment directory without asking
+      and a manifest records which boxes are in each segment.
+    - On Linux, copyDir now clones files with the FICLONE ioctl (reflinks on btrfs and XFS) or copies them in the kernel with
+      copy_file_range before falling back to QFile::copy.  Saving and loading a cache shows how the files were copied.
+    - The build snapshot hard links the leveldb table files (which Google Earth never rewrites) and clones or copies the rest,
+      and the cache is restored from the snapshot by renaming directories instead of deleting and copying.
+    - Saving and loading a cache copies the files on a thread pool with a progress dialog that can cancel the copy (the partial
+      copy is removed).  The copy can be held to a bandwidth limit set on the Preferences tab.
+    - Loading a cache copies it next to the Google Earth cache directory and swaps it in with renames so a failed or canceled
+      load leaves the current cache alone.  The old cache is removed in the background.
+    - Added the Mount option for Load cache (not on Windows).  The Google Earth cache directory is replaced with a link to the
+      saved cache so switching between saved caches is instant.  With the Protect option the saved cache is staged next to
+      itself first (copying the small index and lock files that Google Earth rewrites and hard linking the rest) and the stage
+      is mounted instead.
+    - Old cache directories (and snapshots and overwritten saved caches) are renamed out of the way and deleted on a low priority
+      background thread.  Anything left over from an earlier run is deleted when geCache starts.
+    - The cache build is run as a set of states driven by the build timer instead of sleeping on the GUI thread.  The final wait
+      over the entire area ends early once Google Earth stops writing to the cache.
+    - The build starts as soon as Google Earth is ready (it has set up its cache, read the network link file, and stopped using
+      the CPU) instead of after fixed waits.
+    - The cache build (Google Earth, the build plan, the dwell timing, the KML files, cache monitoring, and saving or restoring
+      the cache when it fills up) has been moved out of the main window into a BuildEngine that reports to the GUI with signals.
+      The engine is declared in geCacheEngine.hpp, which doesn't pull in QtWidgets.
+    - Added batch builds from the command line (geCache --build AREA.kml --out SAVE_DIR [--box-size METERS] [--dwell SECONDS]).
+      No widgets are created, the cache is saved to numbered segments, progress is written to stdout, and the exit code says
+      how the build went.  Load cache now also reads area files with all of the coordinates on one line.
+    - Added a build job queue.  The "Queue build" button (or geCache --build ... --queue) adds an area with its own area size,
+      update frequency, and save name to a queue that is kept across restarts, and geCache --run-queue builds and saves every
+      job in the queue back to back without the GUI.  Jobs can be queued while the queue is being run.
+
 </pre>*/